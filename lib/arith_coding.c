@@ -1,9 +1,23 @@
+#ifdef AC_STATS
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
+#include <time.h>
 
 #include "arith_coding.h"
+#include "histogram.h"
+
+/** statistics statements, compiled only if AC_STATS is defined */
+#ifdef AC_STATS
+#define AC_STAT(...) __VA_ARGS__
+#else
+#define AC_STAT(...)
+#endif
 
 #ifndef DEBUG
 #define DEBUG_PRINTF(...)
@@ -16,37 +30,155 @@
 #endif
 
 
-void init_state(ac_state_t* state, int precision) 
+/** Initialize the fields of @p state, its tables being already set */
+static void init_state_fields(ac_state_t* state, int precision, int alphabet_size)
 {
-  state->prob_table = malloc(sizeof(int) * 256);
-  state->cumul_table = malloc(sizeof(int) * 257);
+  assert(alphabet_size >= 2 && alphabet_size <= AC_MAX_ALPHABET && alphabet_size <= (1 << (precision - 2)) &&
+         "unsupported alphabet size");
 
   state->frac_size = precision;
+  state->alphabet_size = alphabet_size;
 
-  state->one_counter = 0;
   state->last_symbol = -1;
 
   state->current_symbol = 0;
   state->current_index  = 0;
 
-  state->out_index = 0;
+  init_encoding(state);
 
-  state->base = 0;
-  state->length = (1 << precision) - 1;
+  state->update_range = 0;
+  state->range_clear  = 0;
+  state->update_count = 0;
+
+  state->decode_table = NULL;
+  state->decode_bits  = 0;
+  state->read_only    = 0;
+
+  ac_reset_stats(state);
+}
+
+void init_state(ac_state_t* state, int precision) 
+{
+  init_state_alphabet(state, precision, 256);
+}
+
+void init_state_alphabet(ac_state_t* state, int precision, int alphabet_size)
+{
+  state->prob_table = malloc(sizeof(int) * alphabet_size);
+  state->cumul_table = malloc(sizeof(int) * (alphabet_size + 1));
+  state->decode_storage = NULL;
+  state->owns_tables    = 1;
+
+  init_state_fields(state, precision, alphabet_size);
 
   assert(state->prob_table && state->cumul_table && "memory allocation failed");
 }
 
+void init_state_with_storage(ac_state_t* state, int precision, ac_storage_t* storage)
+{
+  init_state_with_tables(state, precision, storage->prob_table, storage->cumul_table, storage->decode_table);
+}
+
+void init_state_with_tables(ac_state_t* state, int precision, int* prob_table, int* cumul_table,
+                            uint16_t* decode_storage)
+{
+  state->prob_table     = prob_table;
+  state->cumul_table    = cumul_table;
+  state->decode_storage = decode_storage;
+  state->owns_tables    = 0;
+
+  init_state_fields(state, precision, 256);
+}
+
+void ac_reset(ac_state_t* state)
+{
+  state->last_symbol = -1;
+  state->current_symbol = 0;
+  state->current_index  = 0;
+
+  init_encoding(state);
+
+  state->update_range = 0;
+  state->range_clear  = 0;
+  state->update_count = 0;
+
+  ac_reset_stats(state);
+
+  // also rebuilds the lookup table if it is enabled
+  reset_uniform_probability(state);
+}
+
+void ac_free_state(ac_state_t* state)
+{
+  if (state->owns_tables) {
+    free(state->prob_table);
+    free(state->cumul_table);
+  }
+  if (state->decode_table != state->decode_storage) free(state->decode_table);
+
+  state->prob_table   = NULL;
+  state->cumul_table  = NULL;
+  state->decode_table = NULL;
+}
+
+#ifdef AC_STATS
+/** Monotonic time in nanoseconds */
+static uint64_t stats_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+int ac_get_stats(const ac_state_t* state, ac_stats_t* stats)
+{
+#ifdef AC_STATS
+  *stats = state->stats;
+  return 1;
+#else
+  memset(stats, 0, sizeof(ac_stats_t));
+  return 0;
+#endif
+}
+
+void ac_reset_stats(ac_state_t* state)
+{
+  AC_STAT(memset(&state->stats, 0, sizeof(ac_stats_t)));
+}
+
+double ac_stats_entropy(const ac_stats_t* stats)
+{
+  double bits = 0;
+#ifdef AC_STATS
+  uint64_t total = 0;
+  int i;
+
+  for (i = 0; i < 256; ++i) total += stats->symbol_count[i];
+  for (i = 0; i < 256; ++i) {
+    if (stats->symbol_count[i]) {
+      bits += stats->symbol_count[i] * log2((double) total / stats->symbol_count[i]);
+    }
+  }
+#endif
+
+  return bits;
+}
+
 void transform_count_to_cumul(ac_state_t* state, int _)  
 {
+  assert(!state->read_only && "tables borrowed from a model are read-only");
+  AC_STAT(uint64_t start = stats_time());
   int i;
   int size = 0;
-  int alphabet_size = 256;
+  int alphabet_size = state->alphabet_size;
   for (i = 0; i < alphabet_size; ++i) size += state->prob_table[i];
 
   for (i = 0; i < alphabet_size; ++i) {
     int count = state->prob_table[i];
-    int local_prob = ((long long) count * ((1 << state->frac_size)-258)) / (size);
+    // each symbol with a non-zero count is given at least 2 units, so that
+    // its coded interval can not be empty (length >= 0.5 before coding)
+    int local_prob = count ? 2 + ((long long) count * ((1 << state->frac_size) - 2 - 2 * alphabet_size)) / (size) : 0;
     //if (i == 0) state->cumul_table[0] = state->prob_table[0];
     //else state->cumul_table[i] = state->cumul_table[i-1] + state->prob_table[i];
     if (i == 0) {
@@ -54,34 +186,119 @@ void transform_count_to_cumul(ac_state_t* state, int _)
     }
     state->cumul_table[i+1] = state->cumul_table[i] + local_prob;
   }
-  state->cumul_table[256] = ((long long) 1 << state->frac_size) - 1;
+  state->cumul_table[alphabet_size] = ((long long) 1 << state->frac_size) - 1;
+
+  build_decode_lookup(state);
+
+  AC_STAT(state->stats.table_rebuilds++; state->stats.rebuild_ns += stats_time() - start);
 }
 
 void build_probability_table(ac_state_t* state, const unsigned char* in, int size) 
 {
   int alphabet_size = 256;
   int count_weight = 1;
+  size_t count[256];
   int i;
-  // reset 
-  for (i = 0; i < alphabet_size; ++i) state->prob_table[i] = 1;
 
-  // occurences counting
-  for (i = 0; i < size; ++i) state->prob_table[in[i]] += count_weight;
+  assert(!state->read_only && "tables borrowed from a model are read-only");
+  assert(state->alphabet_size == 256 && "byte model requires a 256 symbol alphabet");
+
+  // occurences counting, on the calling thread (tables are also built by
+  // the block and pipeline workers)
+  ac_histogram(count, in, size, 1);
+  for (i = 0; i < alphabet_size; ++i) state->prob_table[i] = 1 + count_weight * count[i];
 
   // normalization according to state format
   transform_count_to_cumul(state, count_weight * size);
 
 }
 
+/** Rebuild the cumulative table of @p state from the quantized counts in
+ *  its probability table (uniform probabilities if all counts are zero) */
+static void load_quantized_counts(ac_state_t* state)
+{
+  int i, size = 0;
+
+  for (i = 0; i < 256; ++i) size += state->prob_table[i];
+  if (size) transform_count_to_cumul(state, size);
+  else reset_uniform_probability(state);
+}
+
+size_t store_probability_table(unsigned char* out, ac_state_t* state, const unsigned char* in, size_t size)
+{
+  size_t count[256];
+
+  ac_histogram(count, in, size, 1);
+
+  return store_probability_counts(out, state, count);
+}
+
+size_t store_probability_counts(unsigned char* out, ac_state_t* state, const size_t count[256])
+{
+  size_t max_count = 0;
+  size_t header_size = 0;
+  int s;
+
+  assert(!state->read_only && "tables borrowed from a model are read-only");
+  assert(state->alphabet_size == 256 && "byte model requires a 256 symbol alphabet");
+  for (s = 0; s < 256; ++s) if (count[s] > max_count) max_count = count[s];
+
+  // quantization to 7 bits, each present symbol keeping a non-zero count
+  for (s = 0; s < 256; ++s) {
+    int q = count[s] ? (int) (((uint64_t) count[s] * 127 + max_count / 2) / max_count) : 0;
+    state->prob_table[s] = count[s] && q == 0 ? 1 : q;
+  }
+
+  for (s = 0; s < 256;) {
+    if (state->prob_table[s]) {
+      out[header_size++] = state->prob_table[s++];
+    } else {
+      int run = 0;
+      while (s + run < 256 && run < 128 && !state->prob_table[s + run]) run++;
+      out[header_size++] = 0x80 | (run - 1);
+      s += run;
+    }
+  }
+
+  load_quantized_counts(state);
+
+  return header_size;
+}
+
+size_t load_probability_table(const unsigned char* in, ac_state_t* state)
+{
+  size_t header_size = 0;
+  int s = 0;
+
+  assert(!state->read_only && "tables borrowed from a model are read-only");
+  assert(state->alphabet_size == 256 && "byte model requires a 256 symbol alphabet");
+  while (s < 256) {
+    int value = in[header_size++];
+    if (value & 0x80) {
+      int run = (value & 0x7f) + 1;
+      assert(s + run <= 256 && "invalid probability table header");
+      while (run--) state->prob_table[s++] = 0;
+    } else {
+      assert(value && "invalid probability table header");
+      state->prob_table[s++] = value;
+    }
+  }
+
+  load_quantized_counts(state);
+
+  return header_size;
+}
+
 void reset_uniform_probability(ac_state_t* state)
 {
-  int alphabet_size = 256;
+  assert(!state->read_only && "tables borrowed from a model are read-only");
+  int alphabet_size = state->alphabet_size;
   int size = 0;
   int i;
 
-  for (i = 0; i < 256; ++i) state->prob_table[i] = 1;
+  for (i = 0; i < alphabet_size; ++i) state->prob_table[i] = 1;
 
-  for (i = 0; i < 256; ++i) {
+  for (i = 0; i < alphabet_size; ++i) {
     int count = state->prob_table[i];
     state->prob_table[i] = ((long long) count * (1 << state->frac_size)) / (size + alphabet_size);
     if (i == 0) {
@@ -90,35 +307,61 @@ void reset_uniform_probability(ac_state_t* state)
     }
     else state->cumul_table[i+1] = state->cumul_table[i] + state->prob_table[i];
   }
+
+  build_decode_lookup(state);
 }
 
 void reset_prob_table(ac_state_t* state)
 {
+  assert(!state->read_only && "tables borrowed from a model are read-only");
   int i;
-  for (i = 0; i < 256; ++i) state->prob_table[i] = 1;
+  for (i = 0; i < state->alphabet_size; ++i) state->prob_table[i] = 1;
+}
+
+void enable_decode_lookup(ac_state_t* state)
+{
+  if (!state->decode_table) {
+    // at least two slots per symbol for large alphabets
+    int bits = AC_LOOKUP_BITS;
+    while ((1 << bits) < 2 * state->alphabet_size) bits++;
+    state->decode_bits  = state->frac_size < bits ? state->frac_size : bits;
+    assert((!state->decode_storage || state->decode_bits <= AC_LOOKUP_BITS) && "lookup storage too small");
+    state->decode_table = state->decode_storage ? state->decode_storage
+                                                : malloc(sizeof(uint16_t) * ((1 << state->decode_bits) + 1));
+    assert(state->decode_table && "memory allocation failed");
+  }
+  build_decode_lookup(state);
+}
+
+void build_decode_lookup(ac_state_t* state)
+{
+  assert(!state->read_only && "tables borrowed from a model are read-only");
+  if (!state->decode_table) return;
+
+  int shift = state->frac_size - state->decode_bits;
+  int slots = 1 << state->decode_bits;
+  int last  = state->alphabet_size - 1;
+  int i, s = 0;
+  for (i = 0; i < slots; ++i) {
+    // first symbol whose interval ends after the slot start (the table
+    // may not cover the whole unit range for some alphabet sizes)
+    while (s < last && state->cumul_table[s + 1] <= (i << shift)) s++;
+    state->decode_table[i] = s;
+  }
+  state->decode_table[slots] = last;
 }
 
 void display_prob_table(ac_state_t* state) 
 {
   int i;
   double norm = (double) ((1 << state->frac_size));
-  for (i = 0; i < 256; i++) {
+  for (i = 0; i < state->alphabet_size; i++) {
     printf("P[%i]=%.6f, C[%i/%x]=%.6f / %x\n", i, state->prob_table[i] / norm, i, i, state->cumul_table[i] / norm, state->cumul_table[i]); 
   }
-  i = 256;
+  i = state->alphabet_size;
   printf("P[%i]=%.6f, C[%i/%02x]=%.6f / %x\n", i, 0.0, i, i, state->cumul_table[i] / norm, state->cumul_table[i]); 
 }
 
-/** Set the bit of index @p index in @p out to the value @p bit_value */
-void set_bit_value(unsigned char* out, int index, int bit_value) 
-{
-  if (bit_value) {
-    out[index / 8] |= (1 << (7 - (index % 8)));
-  } else {
-    out[index / 8] &= ~(1 << ((7 - index % 8)));
-  }
-}
-
 /** extract a bit value
   * @p out byte-array to read from
   * @p index bit index to be extracted
@@ -129,53 +372,113 @@ int get_bit_value(unsigned char* out, int index)
   return (out[index / 8] >> (7 - (index % 8))) & 0x1;
 }
 
-/** output a zero value bit value to AC state output
- *  @p out byte-array used as output stream
- *  @p state AC structure containing write pointer to @p out
- */ 
-unsigned char* output_zero(unsigned char* out, ac_state_t* state) 
+/** Store a 64-bit word in @p out, most significant byte first
+ *  @p out byte-array to write to
+ *  @p word value to be stored
+ */
+static void store_word(unsigned char* out, uint64_t word)
 {
-  assert(state->out_index >= 0 && "out_index must be positive");
-
-  set_bit_value(out, state->out_index, 0);
-  state->out_index++;
+  int i;
+  for (i = 0; i < 8; ++i) out[i] = (unsigned char) (word >> (56 - 8 * i));
+}
 
-  return NULL;
+/** Load a 64-bit word from @p in, most significant byte first
+ *  @p in byte-array to read from
+ *  @return loaded value
+ */
+static uint64_t load_word(const unsigned char* in)
+{
+  uint64_t word = 0;
+  int i;
+  for (i = 0; i < 8; ++i) word = (word << 8) | in[i];
+  return word;
 }
 
-/** output a one value bit value to AC state output
+/** Output the @p count least significant bits of @p bits (most significant
+ *  first) to AC state output, the bits are accumulated in the state
+ *  word buffer and written to @p out by 64-bit words
  *  @p out byte-array used as output stream
- *  @p state AC structure containing write pointer to @p out
- */ 
-unsigned char* output_one(unsigned char* out, ac_state_t* state) 
+ *  @p state AC structure containing the bit writer
+ *  @p bits value to be written
+ *  @p count number of bits to be written (at most 32)
+ */
+static void output_bits(unsigned char* out, ac_state_t* state, uint64_t bits, int count)
 {
-  assert(state->out_index >= 0 && "out_index must be positive");
+  int room = 64 - state->bit_count;
+
+  if (state->run_length) {
+    // streaming: kept after the run of digits waiting to be written
+    assert(state->tail_count + count <= 64 && "digit tail overflow");
+    state->tail_bits   = (state->tail_bits << count) | bits;
+    state->tail_count += count;
+  } else if (count < room) {
+    state->bit_buffer = (state->bit_buffer << count) | bits;
+    state->bit_count += count;
+  } else {
+    int left = count - room;
+    assert(state->stream_phase == AC_STREAM_OFF && "streaming output must be drained before coding");
+    if (state->byte_index + 8 <= state->out_limit) {
+      store_word(out + state->byte_index, (state->bit_buffer << room) | (bits >> left));
+    }
+    state->byte_index += 8;
+    state->bit_buffer = bits & (((uint64_t) 1 << left) - 1);
+    state->bit_count  = left;
+  }
+  state->out_index += count;
+}
 
-  set_bit_value(out, state->out_index, 1);
-  state->out_index++;
+/** Write the bits remaining in the state word buffer to @p out,
+ *  padding the last byte with zeros
+ *  @p out byte-array used as output stream
+ *  @p state AC structure containing the bit writer
+ */
+static void flush_bits(unsigned char* out, ac_state_t* state)
+{
+  while (state->bit_count >= 8) {
+    state->bit_count -= 8;
+    if (state->byte_index < state->out_limit) {
+      out[state->byte_index] = (unsigned char) (state->bit_buffer >> state->bit_count);
+    }
+    state->byte_index++;
+  }
+  if (state->bit_count > 0) {
+    if (state->byte_index < state->out_limit) {
+      out[state->byte_index] = (unsigned char) (state->bit_buffer << (8 - state->bit_count));
+    }
+    state->byte_index++;
+  }
+  state->bit_buffer = 0;
+  state->bit_count  = 0;
+}
 
-  return NULL;
+/** Refill the state word buffer with the next bits of @p in
+ *  @p in byte-array used as input stream
+ *  @p state AC structure containing the bit reader
+ */
+static void refill_bits(const unsigned char* in, ac_state_t* state)
+{
+  state->bit_buffer |= load_word(in + state->byte_index) >> state->bit_count;
+  state->byte_index += (63 - state->bit_count) >> 3;
+  state->bit_count  |= 56;
 }
 
-/** Output an arbitrary digit
- *  @p out output byte array
- *  @p state AC structure containing the write pointer
- *  @p digit bit value to be written (should be 0 or 1 )
+/** Extract the next @p count bits of the input stream
+ *  @p in byte-array used as input stream
+ *  @p state AC structure containing the bit reader
+ *  @p count number of bits to be extracted (between 1 and 32)
+ *  @return extracted bits, the first one being the most significant
  */
-void output_digit(unsigned char* out, ac_state_t* state, int digit)
+static int input_bits(const unsigned char* in, ac_state_t* state, int count)
 {
-  switch (digit) {
-  case 0:
-    output_zero(out, state);
-    break;
-  case 1:
-    output_one(out, state);
-    break;
-  default:
-    DEBUG_PRINTF("unexpected digit=%d\n", digit);
-    assert(0 && "unexpected digit value in output_digit\n");
-    break;
-  }
+  int bits;
+
+  if (state->bit_count < count) refill_bits(in, state);
+
+  bits = (int) (state->bit_buffer >> (64 - count));
+  state->bit_buffer <<= count;
+  state->bit_count   -= count;
+
+  return bits;
 }
 
 /** Display a byte array as a bit string
@@ -192,18 +495,99 @@ void display_bin(unsigned char* out, int bit_size)
 #endif
 }
 
-/** Process the step of carry propagation without an AC output stream
+/** Output @p count copies of the digit @p digit
+ *  @p out byte-array used as output stream
+ *  @p state AC structure containing the bit writer
+ */
+static void output_run(unsigned char* out, ac_state_t* state, int digit, int count)
+{
+  uint64_t bits = digit ? 0xffffffff : 0;
+
+  if (state->stream_phase != AC_STREAM_OFF && count > 16) {
+    // streaming: a long run (there is at most one per symbol) is written
+    // progressively to fit the output buffer, shorter ones fit in the word
+    // buffer with the other digits of the symbol
+    assert(!state->run_length && "at most one long run of digits per symbol");
+    state->run_digit  = digit;
+    state->run_length = count;
+    state->out_index += count;
+    return;
+  }
+
+  for (; count >= 32; count -= 32) output_bits(out, state, bits, 32);
+  if (count > 0) output_bits(out, state, bits >> (32 - count), count);
+}
+
+/** Output the carry chain (pending 0 followed by one_counter 1s)
+ *  once it is known whether a carry reached it
+ *  @p out byte-array used as output stream
+ *  @p state AC structure containing the carry chain
+ *  @p carry 1 if a carry was added to the chain, 0 else
+ */
+static void release_chain(unsigned char* out, ac_state_t* state, int carry)
+{
+  if (state->pending_zero) {
+    output_bits(out, state, carry, 1);
+    output_run(out, state, !carry, state->one_counter);
+  }
+  state->pending_zero = 0;
+  state->one_counter  = 0;
+}
+
+/** Output renormalization digits, holding back the last 0 digit and the
+ *  following 1 digits (the only ones a later carry can modify) so that
+ *  bytes written to the output stream are never revisited
+ *  @p out byte-array used as output stream
+ *  @p state AC structure containing the carry chain
+ *  @p digits digits to be output, the first one being the most significant
+ *  @p count number of digits (at most 32)
+ */
+static void output_digits(unsigned char* out, ac_state_t* state, uint32_t digits, int count)
+{
+  uint32_t zeros = ~digits & (0xffffffff >> (32 - count));
+
+  if (!zeros) {
+    // 1 digits either extend the chain or can not be reached by a carry
+    if (state->pending_zero) state->one_counter += count;
+    else output_bits(out, state, digits, count);
+    return;
+  }
+
+  // the last 0 digit starts a new chain, completing the previous one
+#ifdef __GNUC__
+  int ones = __builtin_ctz(zeros);
+#else
+  int ones = 0;
+  while (!((zeros >> ones) & 1)) ones++;
+#endif
+  release_chain(out, state, 0);
+  if (count - ones - 1 > 0) output_bits(out, state, digits >> (ones + 1), count - ones - 1);
+  state->pending_zero = 1;
+  state->one_counter  = ones;
+}
+
+/** Process the step of carry propagation on the pending carry chain,
+ *  without modifying the AC output stream
  *  @p out byte-array used as AC output stream
  *  @p state AC structure containing output parameters
  */
 void propagate_carry(unsigned char* out, ac_state_t* state) 
 {
-  int index = state->out_index - 1;
-  while (get_bit_value(out, index) == 1) {
-    set_bit_value(out, index, 0);
-    index--;
+  assert(state->pending_zero && "carry can not propagate to output digits");
+
+  AC_STAT(uint64_t digits = state->one_counter + 1;
+          state->stats.carries++;
+          state->stats.carry_digits += digits;
+          if (digits > state->stats.max_carry_digits) state->stats.max_carry_digits = digits);
+
+  // 0 1 ... 1 becomes 1 0 ... 0, only the last 0 can still be reached
+  int zeros = state->one_counter;
+  state->one_counter = 0;
+  release_chain(out, state, 1);
+  if (zeros > 0) {
+    output_run(out, state, 0, zeros - 1);
+    state->pending_zero = 1;
   }
-  set_bit_value(out, index, 1);
 }
 
 /** Compute the half unit value for @p state
@@ -225,47 +609,155 @@ int modulo_precision(ac_state_t* state, int value)
   return value % (1 << state->frac_size);
 }
 
-void encode_character(unsigned char* out, unsigned char in, ac_state_t* state) 
+/** Compute the number of renormalization steps (doublings) required
+ *  to bring @p length back above the half unit value of @p state
+ *  @p state AC structure which contains computation parameters
+ *  @p length interval length (must be strictly positive)
+ *  @return number of bits to be shifted out during renormalization
+ */
+static int renorm_shift(ac_state_t* state, int length)
 {
-  int in_cumul   = state->cumul_table[in];
+#ifdef __GNUC__
+  int shift = __builtin_clz((unsigned) length) - (32 - state->frac_size);
+  return shift > 0 ? shift : 0;
+#else
+  int shift = 0;
+  while ((length << shift) < state_half_length(state)) shift++;
+  return shift;
+#endif
+}
 
-  // interval update
-  int Y = ((long long) state->length * state->cumul_table[in + 1]) >> state->frac_size;
-  int base_increment = ((long long) state->length * in_cumul) >> state->frac_size;
+/** Shift @p value left by @p shift and reduce it modulo precision */
+static int shift_precision(ac_state_t* state, int value, int shift)
+{
+  return (int) (((uint64_t) value << shift) & ((1u << state->frac_size) - 1));
+}
 
+/** Narrow the coding interval of @p state to the sub-interval
+ *  [base_increment, Y) of the current one, propagating carry and
+ *  renormalizing
+ *  @p out byte-array used as output stream
+ *  @p state AC structure
+ *  @p base_increment start of the sub-interval, scaled to state->length
+ *  @p Y end of the sub-interval, scaled to state->length
+ */
+static inline void narrow_interval(unsigned char* out, ac_state_t* state, int base_increment, int Y)
+{
   int new_base   = modulo_precision(state, state->base + base_increment);
   int new_length = Y - base_increment;
 
   assert(new_base >= 0 && new_length > 0 && "intermediary values must be positive");
 
+  AC_STAT(state->stats.symbols++;
+          state->stats.info_bits += log2((double) state->length / new_length));
+
   if (new_base < state->base) {
     // propagate carry
     propagate_carry(out, state);
   }
 
-
-  while (new_length < state_half_length(state)) {
-    // renormalization
-    int digit = (new_base * 2) >> state->frac_size;
-    output_digit(out, state, digit);
-    new_length = modulo_precision(state, 2 * new_length);
-    new_base   = modulo_precision(state, 2 * new_base);
+  // renormalization: all the digits are output at once
+  int shift = renorm_shift(state, new_length);
+  AC_STAT(state->stats.renorm_bits += shift);
+  if (shift > 0) {
+    output_digits(out, state, new_base >> (state->frac_size - shift), shift);
+    new_length = shift_precision(state, new_length, shift);
+    new_base   = shift_precision(state, new_base, shift);
   }
 
   state->base   = new_base;
   state->length = new_length;
+}
+
+/** Select the sub-interval [X, Y) of the decoding interval of @p state
+ *  (V being the offset of the code value in it) and renormalize
+ *  @p in byte-array used as input stream
+ *  @p state AC structure
+ *  @p X start of the sub-interval, scaled to state->length
+ *  @p Y end of the sub-interval, scaled to state->length
+ */
+static inline void select_interval(unsigned char* in, ac_state_t* state, int X, int Y)
+{
+  int V      = state->base - X;
+  int length = Y - X;
+
+  AC_STAT(state->stats.symbols++;
+          state->stats.info_bits += log2((double) state->length / length));
+
+  // renormalization: all the digits are input at once
+  int shift = renorm_shift(state, length);
+  AC_STAT(state->stats.renorm_bits += shift);
+  if (shift > 0) {
+    V = shift_precision(state, V, shift) + input_bits(in, state, shift);
+    length = shift_precision(state, length, shift);
+    state->out_index += shift;
+  }
 
+  state->length = length;
+  state->base   = V;
 }
 
-unsigned char decode_character( unsigned char* in, ac_state_t* state) 
+/** Scale the cumulative frequency @p cumul (out of @p total) to the
+ *  current interval length of @p state */
+static inline int scale_length(ac_state_t* state, uint32_t cumul, uint32_t total)
+{
+  if (state->frac_size <= 16) return (uint32_t) state->length * cumul / total;
+  return (uint64_t) state->length * cumul / total;
+}
+
+/** Encode symbol @p in with the cumulative table of @p state */
+static inline void encode_table_symbol(unsigned char* out, int in, ac_state_t* state)
+{
+  int in_cumul   = state->cumul_table[in];
+
+  // interval update
+  int Y = ((long long) state->length * state->cumul_table[in + 1]) >> state->frac_size;
+  int base_increment = ((long long) state->length * in_cumul) >> state->frac_size;
+
+  AC_STAT(if (in < 256) state->stats.symbol_count[in]++);
+  narrow_interval(out, state, base_increment, Y);
+}
+
+void encode_character(unsigned char* out, unsigned char in, ac_state_t* state) 
+{
+  encode_table_symbol(out, in, state);
+}
+
+void encode_symbol(unsigned char* out, uint16_t in, ac_state_t* state)
+{
+  assert(in < state->alphabet_size && "symbol out of alphabet");
+  encode_table_symbol(out, in, state);
+}
+
+void encode_interval(unsigned char* out, ac_state_t* state, uint32_t cum_low, uint32_t cum_high, uint32_t total)
+{
+  assert(cum_low < cum_high && cum_high <= total && total <= state_half_length(state) &&
+         "invalid interval");
+  narrow_interval(out, state, scale_length(state, cum_low, total), scale_length(state, cum_high, total));
+}
+
+/** Decode a symbol with the cumulative table of @p state */
+static inline int decode_table_symbol(unsigned char* in, ac_state_t* state)
 {
   // input value
   int length = state->length;
   int V      = state->base;
-  int t      = state->out_index;
 
   // interval selection
-  int s = 0, n = 256, X = 0, Y = ((long long) length * state->cumul_table[256]) >> state->frac_size;
+  int s = 0, n = state->alphabet_size, X = 0, Y;
+  if (state->decode_table) {
+    // V lies in the symbol interval containing cumulative value t
+    // (up to t + 3 as length >= 0.5), which narrows the search
+    // to the symbols overlapping the corresponding lookup slots
+    int shift = state->frac_size - state->decode_bits;
+    int t     = state->frac_size <= 16 ? ((uint32_t) V << state->frac_size) / (uint32_t) length
+                                     : ((uint64_t) V << state->frac_size) / length;
+    int last  = (t + 3) >> shift;
+    s = state->decode_table[t >> shift];
+    n = last < (1 << state->decode_bits) ? state->decode_table[last + 1] + 1 : state->alphabet_size;
+    X = ((long long) length * state->cumul_table[s]) >> state->frac_size;
+  }
+  Y = ((long long) length * state->cumul_table[n]) >> state->frac_size;
   while (n - s > 1) {
     int m = (s + n) / 2;
     int Z = ((long long) length * state->cumul_table[m]) >> state->frac_size;
@@ -273,25 +765,66 @@ unsigned char decode_character( unsigned char* in, ac_state_t* state)
     if (Z > V) { n = m; Y = Z;}
     else { s = m; X = Z;};
   }
-  V = V - X;
-  length = Y - X;
-
-  while (length < state_half_length(state)) {
-    // renormalization
-    t++;
-    V = modulo_precision(state, 2 * V) + get_bit_value(in, t);
-    length = modulo_precision(state, 2 * length);
-  }
 
-  //output
-  state->length    = length;
-  state->base      = V;
-  state->out_index = t;
+  select_interval(in, state, X, Y);
+  AC_STAT(if (s < 256) state->stats.symbol_count[s]++);
 
   return s;
 }
 
-void select_value(unsigned char* out, ac_state_t* state) 
+unsigned char decode_character( unsigned char* in, ac_state_t* state) 
+{
+  return decode_table_symbol(in, state);
+}
+
+uint16_t decode_symbol(unsigned char* in, ac_state_t* state)
+{
+  return decode_table_symbol(in, state);
+}
+
+uint32_t decode_target(ac_state_t* state, uint32_t total)
+{
+  // largest cumulative value c such that length * c / total <= V
+  return (((uint64_t) state->base + 1) * total - 1) / (uint32_t) state->length;
+}
+
+void decode_interval(unsigned char* in, ac_state_t* state, uint32_t cum_low, uint32_t cum_high, uint32_t total)
+{
+  select_interval(in, state, scale_length(state, cum_low, total), scale_length(state, cum_high, total));
+}
+
+void init_encoding(ac_state_t* state)
+{
+  state->one_counter  = 0;
+  state->pending_zero = 0;
+
+  state->out_index = 0;
+
+  state->base = 0;
+  state->length = (1 << state->frac_size) - 1;
+
+  state->bit_buffer = 0;
+  state->bit_count  = 0;
+  state->byte_index = 0;
+  state->out_limit  = SIZE_MAX;
+
+  state->stream_phase = AC_STREAM_OFF;
+  state->run_length   = 0;
+  state->tail_count   = 0;
+
+  state->bin_low        = 0;
+  state->bin_range      = 0xffffffff;
+  state->bin_code       = 0;
+  state->bin_cache      = 0;
+  state->bin_cache_size = 1;
+}
+
+/** Select a final numerical value and output its digits (without flushing
+ *  the bit writer)
+ *  @param out output stream
+ *  @param state internal arithmetic encoding state
+ */
+static void terminate_value(unsigned char* out, ac_state_t* state)
 {
   // code value selection (flushing buffer)
   int base = state->base;
@@ -300,12 +833,24 @@ void select_value(unsigned char* out, ac_state_t* state)
   if (base > new_base) propagate_carry(out, state);
 
   // renormalization (output two symbols)
-  while (new_length < state_half_length(state)) {
-    int digit = (new_base * 2) >> state->frac_size;
-    output_digit(out, state, digit);
-    new_length = modulo_precision(state, 2 * new_length);
-    new_base   = modulo_precision(state, 2 * new_base);
-  }
+  int shift = renorm_shift(state, new_length);
+  output_digits(out, state, new_base >> (state->frac_size - shift), shift);
+
+  release_chain(out, state, 0);
+}
+
+void select_value(unsigned char* out, ac_state_t* state) 
+{
+  terminate_value(out, state);
+  flush_bits(out, state);
+}
+
+size_t encode_bound(size_t size, int precision)
+{
+  // each symbol interval is at least one unit wide: at most (precision - 1)
+  // renormalization bits per symbol, plus 2 termination bits and the
+  // decoder read-ahead
+  return (size * (precision - 1) + 2 + 7) / 8 + AC_DECODE_PADDING;
 }
 
 void encode_value(unsigned char* out, const unsigned char* in, size_t size, ac_state_t* state) 
@@ -321,11 +866,13 @@ void encode_value(unsigned char* out, const unsigned char* in, size_t size, ac_s
 void init_decoding(unsigned char* in, ac_state_t* state)
 {
   int length = (1 << state->frac_size) - 1;
-  int V = 0;
-  int k;
-  for (k = 0; k < state->frac_size; k++) {
-    V |= get_bit_value(in, k) << (state->frac_size - 1 - k);
-  }
+
+  // reseting bit reader
+  state->bit_buffer = 0;
+  state->bit_count  = 0;
+  state->byte_index = 0;
+
+  int V = input_bits(in, state, state->frac_size);
 
   int t = state->frac_size - 1;
 
@@ -346,91 +893,580 @@ void decode_value(unsigned char* out, unsigned char* in, ac_state_t* state, size
 
 }
 
+size_t encode_value_with_table(unsigned char* out, const unsigned char* in, size_t size, ac_state_t* state)
+{
+  size_t header_size = store_probability_table(out, state, in, size);
+
+  init_encoding(state);
+  encode_value(out + header_size, in, size, state);
+
+  return header_size + state->byte_index;
+}
+
+void decode_value_with_table(unsigned char* out, unsigned char* in, ac_state_t* state, size_t expected_size)
+{
+  size_t header_size = load_probability_table(in, state);
+
+  decode_value(out, in + header_size, state, expected_size);
+}
+
+/** log2(@p x) in 16.16 fixed point (@p x > 0), the fractional bits
+ *  being obtained by repeated squaring of the mantissa */
+static uint32_t log2_fixed(uint32_t x)
+{
+  int bits = 31, i;
+  while (!(x >> bits)) bits--;
+
+  // mantissa in [1, 2) with 31 fractional bits
+  uint64_t m = ((uint64_t) x << 31) >> bits;
+  uint32_t result = (uint32_t) bits << 16;
+  for (i = 15; i >= 0; --i) {
+    m = (m * m) >> 31;
+    if (m >> 32) {
+      result |= 1u << i;
+      m >>= 1;
+    }
+  }
+
+  return result;
+}
+
+size_t estimate_coded_size(const unsigned char* in, size_t size)
+{
+  const size_t runs = 64, run_size = AC_SAMPLE_SIZE / 64;
+  uint32_t count[256] = {0};
+  size_t sampled = 0, r, j;
+
+  if (!size) return 0;
+
+  if (size <= AC_SAMPLE_SIZE) {
+    for (j = 0; j < size; ++j) count[in[j]]++;
+    sampled = size;
+  } else {
+    // runs evenly spread from the start to the end of the input
+    size_t stride = (size - run_size) / (runs - 1);
+    for (r = 0; r < runs; ++r) {
+      const unsigned char* run = in + r * stride;
+      for (j = 0; j < run_size; ++j) count[run[j]]++;
+    }
+    sampled = runs * run_size;
+  }
+
+  // sample entropy (16.16 fixed-point bits), with the Miller-Madow
+  // correction of its bias: (distinct symbols - 1) / (2 ln 2) bits
+  uint32_t log_sampled = log2_fixed(sampled);
+  uint64_t bits = 0;
+  int distinct = 0, i;
+  for (i = 0; i < 256; ++i) {
+    if (!count[i]) continue;
+    bits += (uint64_t) count[i] * (log_sampled - log2_fixed(count[i]));
+    distinct++;
+  }
+  bits += (uint64_t) (distinct - 1) * 47274;
+
+  uint64_t bits_per_byte = bits / sampled;
+  return (bits_per_byte * size + (1 << 19) - 1) >> 19;
+}
+
+size_t encode_value_interleaved(unsigned char* out, const unsigned char* in, size_t size, ac_state_t* state, int lanes)
+{
+  assert((lanes == 2 || lanes == 4 || lanes == 8) && "unsupported lane count");
+
+  size_t offset = 1 + 4 * (lanes - 1);
+  int j, k;
+
+  out[0] = lanes;
+  for (j = 0; j < lanes; ++j) {
+    ac_state_t lane = *state;
+    size_t i;
+
+    init_encoding(&lane);
+    for (i = j; i < size; i += lanes) encode_character(out + offset, in[i], &lane);
+    select_value(out + offset, &lane);
+
+    // lane size header (the last lane extends to the end of the stream)
+    if (j < lanes - 1) {
+      assert(lane.byte_index <= 0xffffffff && "lane too large");
+      for (k = 0; k < 4; ++k) out[1 + 4 * j + k] = (unsigned char) (lane.byte_index >> (24 - 8 * k));
+    }
+    offset += lane.byte_index;
+  }
+
+  return offset;
+}
+
+/** Decode @p groups groups of @p lanes symbols (one per lane) from the
+ *  interleaved lane streams, @p lanes being a compile-time constant
+ *  at each call site so that the lane loop is unrolled and the
+ *  independent lane decodings overlap
+ */
+static inline void decode_lane_groups(unsigned char* out, unsigned char** lane_in, ac_state_t* lane, size_t groups, int lanes)
+{
+  size_t i;
+  int j;
+  for (i = 0; i < groups; ++i) {
+    for (j = 0; j < lanes; ++j) out[j] = decode_character(lane_in[j], lane + j);
+    out += lanes;
+  }
+}
+
+void decode_value_interleaved(unsigned char* out, unsigned char* in, ac_state_t* state, size_t expected_size)
+{
+  int lanes = in[0];
+  assert((lanes == 2 || lanes == 4 || lanes == 8) && "unsupported lane count");
+
+  ac_state_t lane[AC_MAX_LANES];
+  unsigned char* lane_in[AC_MAX_LANES];
+  size_t offset = 1 + 4 * (lanes - 1);
+  int j, k;
+
+  for (j = 0; j < lanes; ++j) {
+    lane[j]    = *state;
+    lane_in[j] = in + offset;
+    init_decoding(lane_in[j], lane + j);
+    if (j < lanes - 1) {
+      size_t lane_size = 0;
+      for (k = 0; k < 4; ++k) lane_size = (lane_size << 8) | in[1 + 4 * j + k];
+      offset += lane_size;
+    }
+  }
+
+  size_t groups = expected_size / lanes;
+  switch (lanes) {
+  case 2: decode_lane_groups(out, lane_in, lane, groups, 2); break;
+  case 4: decode_lane_groups(out, lane_in, lane, groups, 4); break;
+  default: decode_lane_groups(out, lane_in, lane, groups, 8); break;
+  }
+
+  // remaining symbols (first lanes)
+  out += groups * lanes;
+  for (j = 0; j < expected_size % lanes; ++j) out[j] = decode_character(lane_in[j], lane + j);
+}
+
+/** Account for @p symbol in the occurence counts of @p state, updating
+ *  the cumulative table every state->update_range symbols
+ *  @param state arithmetic coder state
+ *  @param symbol last coded symbol
+ */
+static void update_probability(ac_state_t* state, int symbol)
+{
+  assert(!state->read_only && "tables borrowed from a model are read-only");
+  // updating prob
+  state->prob_table[symbol]++;
+  state->update_count++;
+
+  // updating cumul table
+  if (state->update_count >= state->update_range) {
+    transform_count_to_cumul(state, state->update_count);
+    state->update_count = 0;
+    // reseting count
+    if (state->range_clear) reset_prob_table(state);
+  }
+}
+
 void encode_value_with_update(unsigned char* out, unsigned char* in, size_t size, ac_state_t* state, int update_range, int range_clear) 
 {
   int i;
-  int update_count = 0;
 
   // reseting count
-  for (i = 0; i < 256; i++) state->prob_table[i] = 1;
+  reset_prob_table(state);
+  state->update_range = update_range;
+  state->range_clear  = range_clear;
+  state->update_count = 0;
   
   // encoding each character
   for (i = 0; i < size; ++i) {
     unsigned char input_char = in[i];
     encode_character(out, input_char, state);
-    // updating prob
-    state->prob_table[input_char]++;
-    update_count++;
-
-    // updating cumul table
-    if (update_count >= update_range) {
-      transform_count_to_cumul(state, update_count);
-      // reseting count
-      if (range_clear) {
-        update_count = 0;
-        int j;
-        for (j = 0; j < 256; j++) state->prob_table[j] = 1;
-      }
-    }
+    update_probability(state, input_char);
   }
 
   // code value selection (flushing buffer)
+  select_value(out, state);
+}
 
-  int base = state->base;
-  int new_base = modulo_precision(state, state->base + state_half_length(state) / 2);
-  int new_length = (1 << (state->frac_size - 2)) - 1;
-  if (base > new_base) propagate_carry(out, state);
+void decode_value_with_update(unsigned char* out, unsigned char* in, ac_state_t* state, size_t expected_size, int update_range, int range_clear) 
+{
+  int i;
 
-  // renormalization (output two symbols)
-  while (new_length < state_half_length(state)) {
-    int digit = (new_base * 2) >> state->frac_size;
-    output_digit(out, state, digit);
-    new_length = modulo_precision(state, 2 * new_length);
-    new_base   = modulo_precision(state, 2 * new_base);
+  // reseting count
+  reset_prob_table(state);
+  state->update_range = update_range;
+  state->range_clear  = range_clear;
+  state->update_count = 0;
+
+  init_decoding(in, state);
+
+  for (i = 0; i < expected_size; ++i) {
+    unsigned char decoded_char = decode_character(in, state);
+    *(out++) = decoded_char; 
+    update_probability(state, decoded_char);
   }
+
 }
 
-void decode_value_with_update(unsigned char* out, unsigned char* in, ac_state_t* state, size_t expected_size, int update_range, int range_clear) 
+int estimate_compressible(const unsigned char* in, size_t size)
 {
-  int update_count = 0;
-  int length = (1 << state->frac_size) - 1;
-  int V = 0;
-  int k;
-  for (k = 0; k < state->frac_size; k++) {
-    V |= get_bit_value(in, k) << (state->frac_size - 1 - k);
+  return size && estimate_coded_size(in, size) <= size - size / AC_MIN_GAIN;
+}
+
+size_t store_value_raw(unsigned char* out, const unsigned char* in, size_t size)
+{
+  out[0] = AC_BLOCK_RAW;
+  memcpy(out + 1, in, size);
+
+  return 1 + size;
+}
+
+size_t auto_bound(size_t size)
+{
+  return 1 + size;
+}
+
+size_t encode_value_auto(unsigned char* out, const unsigned char* in, size_t size,
+                         ac_state_t* state, int update_range, int range_clear)
+{
+  if (estimate_compressible(in, size) && size > AC_DECODE_PADDING) {
+    // the coded value is given up as soon as it reaches the raw size, less
+    // the decoder read-ahead (kept within the auto_bound buffer)
+    size_t limit = size - AC_DECODE_PADDING;
+    size_t i;
+
+    // same coding as encode_value_with_update, from a uniform table
+    init_encoding(state);
+    reset_uniform_probability(state);
+    reset_prob_table(state);
+    state->update_range = update_range;
+    state->range_clear  = range_clear;
+    state->update_count = 0;
+
+    state->out_limit = limit;
+    for (i = 0; i < size && state->byte_index < limit; ++i) {
+      encode_character(out + 1, in[i], state);
+      update_probability(state, in[i]);
+    }
+    if (state->byte_index < limit) select_value(out + 1, state);
+    state->out_limit = SIZE_MAX;
+
+    if (state->byte_index < limit) {
+      out[0] = AC_BLOCK_CODED;
+      return 1 + state->byte_index;
+    }
+  }
+
+  // hopeless block (or estimate missed): stored as is
+  return store_value_raw(out, in, size);
+}
+
+void decode_value_auto(unsigned char* out, unsigned char* in, ac_state_t* state,
+                       size_t expected_size, int update_range, int range_clear)
+{
+  assert((in[0] == AC_BLOCK_RAW || in[0] == AC_BLOCK_CODED) && "invalid block mode");
+
+  if (in[0] == AC_BLOCK_RAW) {
+    memcpy(out, in + 1, expected_size);
+    return;
+  }
+
+  reset_uniform_probability(state);
+  decode_value_with_update(out, in + 1, state, expected_size, update_range, range_clear);
+}
+
+void build_symbol_table(ac_state_t* state, const uint16_t* in, size_t size)
+{
+  size_t i;
+
+  // occurences counting (each symbol keeping a non-zero count)
+  reset_prob_table(state);
+  for (i = 0; i < size; ++i) {
+    assert(in[i] < state->alphabet_size && "symbol out of alphabet");
+    state->prob_table[in[i]]++;
+  }
+
+  transform_count_to_cumul(state, size);
+}
+
+void encode_symbols(unsigned char* out, const uint16_t* in, size_t size, ac_state_t* state)
+{
+  size_t i;
+
+  for (i = 0; i < size; ++i) encode_symbol(out, in[i], state);
+
+  select_value(out, state);
+}
+
+void decode_symbols(uint16_t* out, unsigned char* in, ac_state_t* state, size_t expected_size)
+{
+  size_t i;
+
+  init_decoding(in, state);
+
+  for (i = 0; i < expected_size; ++i) out[i] = decode_symbol(in, state);
+}
+
+void encode_symbols_with_update(unsigned char* out, const uint16_t* in, size_t size, ac_state_t* state,
+                                int update_range, int range_clear)
+{
+  size_t i;
+
+  // reseting count
+  reset_prob_table(state);
+  state->update_range = update_range;
+  state->range_clear  = range_clear;
+  state->update_count = 0;
+
+  for (i = 0; i < size; ++i) {
+    encode_symbol(out, in[i], state);
+    update_probability(state, in[i]);
   }
-  // int V = (in[0] << 8) | in[1];
+
+  // code value selection (flushing buffer)
+  select_value(out, state);
+}
+
+void decode_symbols_with_update(uint16_t* out, unsigned char* in, ac_state_t* state, size_t expected_size,
+                                int update_range, int range_clear)
+{
+  size_t i;
 
   // reseting count
+  reset_prob_table(state);
+  state->update_range = update_range;
+  state->range_clear  = range_clear;
+  state->update_count = 0;
+
+  init_decoding(in, state);
+
+  for (i = 0; i < expected_size; ++i) {
+    out[i] = decode_symbol(in, state);
+    update_probability(state, out[i]);
+  }
+}
+
+/** Rebuild the power-of-two total cumulative table of @p state from the
+ *  occurence counts of the last window (1 << window_bits symbols, counted
+ *  in prob_table which is cleared), see encode_value_with_decay */
+static void decay_probability(ac_state_t* state, int window_bits, int decay_shift)
+{
+  AC_STAT(uint64_t start = stats_time());
+  int count_shift = state->frac_size - window_bits;
+  int freq[256];
+  int i, total = 0, top = 0;
+
+  // each frequency moves 1 / 2^decay_shift of the way to its window
+  // target (the scaled window count, targets summing to the unit value):
+  // rounding down leaves a deficit of less than one unit per symbol
+  for (i = 0; i < 256; ++i) {
+    int64_t f = state->cumul_table[i + 1] - state->cumul_table[i];
+    f = (f * ((1 << decay_shift) - 1) + ((int64_t) state->prob_table[i] << count_shift)) >> decay_shift;
+    freq[i] = f < 2 ? 2 : (int) f;
+    total += freq[i];
+    if (freq[i] > freq[top]) top = i;
+    state->prob_table[i] = 0;
+  }
+
+  // the difference to the unit value goes to the most frequent symbol, any excess it can not absorb being taken one unit
+  // at a time from the symbols above the minimal frequency
+  int excess = total - (1 << state->frac_size);
+  int taken  = excess < freq[top] - 2 ? excess : freq[top] - 2;
+  freq[top] -= taken;
+  excess    -= taken;
+  for (i = 0; excess > 0; i = (i + 1) & 255) {
+    if (freq[i] > 2) {
+      freq[i]--;
+      excess--;
+    }
+  }
+
+  for (i = 0; i < 256; ++i) state->cumul_table[i + 1] = state->cumul_table[i] + freq[i];
+
+  build_decode_lookup(state);
+
+  AC_STAT(state->stats.table_rebuilds++; state->stats.rebuild_ns += stats_time() - start);
+}
+
+/** Reset @p state for encode_value_with_decay/decode_value_with_decay */
+static void init_decay(ac_state_t* state, int window_bits, int decay_shift)
+{
   int i;
-  for (i = 0; i < 256; i++) state->prob_table[i] = 1;
 
-  int t = state->frac_size - 1;
+  assert(state->alphabet_size == 256 && "decay model requires a 256 symbol alphabet");
+  assert(window_bits >= 0 && window_bits <= state->frac_size && decay_shift >= 0 && decay_shift <= 16 &&
+         "invalid decay parameters");
 
-  state->out_index = t;
-  state->base      = V;
-  state->length    = length;
+  reset_uniform_probability(state);
+  for (i = 0; i < 256; ++i) state->prob_table[i] = 0;
+  state->update_range = 1 << window_bits;
+  state->update_count = 0;
+}
+
+void encode_value_with_decay(unsigned char* out, const unsigned char* in, size_t size, ac_state_t* state,
+                             int window_bits, int decay_shift)
+{
+  size_t i;
+
+  init_decay(state, window_bits, decay_shift);
+
+  for (i = 0; i < size; ++i) {
+    encode_character(out, in[i], state);
+    state->prob_table[in[i]]++;
+    if (++state->update_count == state->update_range) {
+      decay_probability(state, window_bits, decay_shift);
+      state->update_count = 0;
+    }
+  }
+
+  // code value selection (flushing buffer)
+  select_value(out, state);
+}
+
+void decode_value_with_decay(unsigned char* out, unsigned char* in, ac_state_t* state, size_t expected_size,
+                             int window_bits, int decay_shift)
+{
+  size_t i;
+
+  init_decay(state, window_bits, decay_shift);
+  init_decoding(in, state);
 
   for (i = 0; i < expected_size; ++i) {
-    unsigned char decoded_char = decode_character(in, state);
-    *(out++) = decoded_char; 
+    out[i] = decode_character(in, state);
+    state->prob_table[out[i]]++;
+    if (++state->update_count == state->update_range) {
+      decay_probability(state, window_bits, decay_shift);
+      state->update_count = 0;
+    }
+  }
+}
 
-    // updating prob
-    state->prob_table[decoded_char]++;
-    update_count++;
-
-    // updating cumul table
-    if (update_count >= update_range) {
-      transform_count_to_cumul(state, update_count);
-      // reseting count
-      if (range_clear) {
-        update_count = 0;
-        int j;
-        for (j = 0; j < 256; j++) state->prob_table[j] = 1;
-      };
+void init_stream(ac_state_t* state, int update_range, int range_clear)
+{
+  init_encoding(state);
+  state->stream_phase = AC_STREAM_START;
+
+  state->update_range = update_range;
+  state->range_clear  = range_clear;
+  state->update_count = 0;
+  if (update_range > 0) {
+    reset_uniform_probability(state);
+    reset_prob_table(state);
+  }
+}
+
+/** Write the pending digits of a streaming encoder to @p out, as long as
+ *  there is room for them
+ *  @param out output buffer of the current call
+ *  @param out_cap number of bytes available in @p out
+ *  @param state streaming encoder state
+ *  @return 1 if less than one byte of digits remains pending, 0 if @p out
+ *          is full
+ */
+static int drain_stream(unsigned char* out, size_t out_cap, ac_state_t* state)
+{
+  while (1) {
+    // complete bytes of the word buffer
+    while (state->bit_count >= 8) {
+      if (state->byte_index >= out_cap) return 0;
+      state->bit_count -= 8;
+      out[state->byte_index++] = (unsigned char) (state->bit_buffer >> state->bit_count);
     }
 
+    if (state->run_length) {
+      // run of digits by pieces of at most 32 digits
+      int count = state->run_length < 32 ? state->run_length : 32;
+      uint64_t bits = state->run_digit ? 0xffffffff >> (32 - count) : 0;
+      state->bit_buffer  = (state->bit_buffer << count) | bits;
+      state->bit_count  += count;
+      state->run_length -= count;
+    } else if (state->tail_count) {
+      state->bit_buffer  = (state->bit_buffer << state->tail_count) | state->tail_bits;
+      state->bit_count  += state->tail_count;
+      state->tail_bits   = 0;
+      state->tail_count  = 0;
+    } else {
+      return 1;
+    }
   }
+}
 
+int ac_encode_stream(ac_state_t* state, const unsigned char* in, size_t in_len,
+                     unsigned char* out, size_t out_cap,
+                     size_t* consumed, size_t* produced, int flush)
+{
+  size_t i = 0;
+  int done = 0;
+
+  assert(state->stream_phase != AC_STREAM_OFF && "state is not initialized for streaming");
+
+  // the writer targets the output buffer of this call
+  state->byte_index = 0;
+  if (state->stream_phase == AC_STREAM_START) state->stream_phase = AC_STREAM_RUN;
+
+  // a symbol is only coded once the previous ones have been written,
+  // so that its digits fit in the word buffer
+  while (drain_stream(out, out_cap, state)) {
+    if (state->stream_phase == AC_STREAM_DONE) {
+      // last partial byte
+      if (state->bit_count == 0 || state->byte_index < out_cap) {
+        flush_bits(out, state);
+        done = 1;
+      }
+      break;
+    }
+    if (i < in_len) {
+      encode_character(out, in[i], state);
+      if (state->update_range > 0) update_probability(state, in[i]);
+      i++;
+    } else if (flush) {
+      terminate_value(out, state);
+      state->stream_phase = AC_STREAM_DONE;
+    } else {
+      break;
+    }
+  }
+
+  *consumed = i;
+  *produced = state->byte_index;
+
+  return done;
 }
 
+int ac_decode_stream(ac_state_t* state, const unsigned char* in, size_t in_len,
+                     unsigned char* out, size_t out_cap,
+                     size_t* consumed, size_t* produced, int flush)
+{
+  size_t i = 0, o = 0;
+  // a symbol consumes at most frac_size - 1 digits (frac_size for the
+  // initial value)
+  int needed = state->frac_size;
+
+  assert(state->stream_phase != AC_STREAM_OFF && "state is not initialized for streaming");
+
+  while (o < out_cap) {
+    // byte by byte refill from the input buffer of this call
+    while (state->bit_count <= 56 && i < in_len) {
+      state->bit_buffer |= (uint64_t) in[i++] << (56 - state->bit_count);
+      state->bit_count  += 8;
+    }
+    if (state->bit_count < needed) {
+      if (!flush) break;
+      // end of the encoded stream: zero digits
+      state->bit_count = 64;
+    }
+
+    if (state->stream_phase == AC_STREAM_START) {
+      state->base   = input_bits(NULL, state, state->frac_size);
+      state->length = (1 << state->frac_size) - 1;
+      state->stream_phase = AC_STREAM_RUN;
+      continue;
+    }
+
+    unsigned char decoded_char = decode_character(NULL, state);
+    out[o++] = decoded_char;
+    if (state->update_range > 0) update_probability(state, decoded_char);
+  }
+
+  *consumed = i;
+  *produced = o;
+
+  return o == out_cap;
+}
@@ -1,21 +1,73 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 /** \defgroup airht_coding arithmetic coding
  *  \brief Arithmetic coding encoding and decoding functions
  *   @{
  */
 
+/** log2 of the number of slots in the decoding lookup table (for
+ *  alphabets of up to 2^(AC_LOOKUP_BITS - 1) symbols) */
+#define AC_LOOKUP_BITS 12
+
+/** maximal number of symbols of the coder alphabet (see
+ *  init_state_alphabet) */
+#define AC_MAX_ALPHABET 65536
+
+/** Caller-provided storage for the tables of a (256 symbol alphabet) state
+ *  (see init_state_with_storage), it can be embedded in a larger structure or
+ *  allocated statically */
+typedef struct
+{
+  int prob_table[256];
+  int cumul_table[257];
+  uint16_t decode_table[(1 << AC_LOOKUP_BITS) + 1];
+} ac_storage_t;
+
+/** Coder statistics, collected only when the library is built with
+ *  AC_STATS defined (make STATS=1), which must then also be defined for
+ *  all the code including this header */
+typedef struct
+{
+  /** number of symbols coded (encoded or decoded) */
+  uint64_t symbols;
+  /** occurences of each byte coded by encode_character/decode_character */
+  uint64_t symbol_count[256];
+  /** number of digits output (or input) by renormalization */
+  uint64_t renorm_bits;
+  /** number of carry propagations, total and maximal number of digits
+   *  flipped by a carry */
+  uint64_t carries;
+  uint64_t carry_digits;
+  uint64_t max_carry_digits;
+  /** number of cumulative table rebuilds (transform_count_to_cumul) and
+   *  time spent in them (in nanoseconds) */
+  uint64_t table_rebuilds;
+  uint64_t rebuild_ns;
+  /** information cost of the coded symbols (in bits): sum of the log2 of
+   *  the interval narrowing ratios */
+  double info_bits;
+} ac_stats_t;
+
 /** Arithmetic Coding state structure */
 typedef struct
 {
-  /** character probability table */
+  /** character probability table (alphabet_size entries) */
   int* prob_table;
-  /** cumulative probabilities table */
+  /** cumulative probabilities table (alphabet_size + 1 entries) */
   int* cumul_table;
+  /** number of symbols of the alphabet (256 for byte coding) */
+  int alphabet_size;
   /** size of fractionnal part */
   int  frac_size;
-  /** one-chain counter */
+  /** one-chain counter: number of 1 digits following the pending 0
+   *  digit, which may still be flipped by a carry */
   int one_counter;
+  /** a 0 digit (followed by one_counter 1 digits) is held back until it
+   *  can no longer be reached by a carry */
+  int pending_zero;
   /** deprecated index */
   int current_index;
   /** position of the next bit to be outputed */
@@ -28,6 +80,58 @@ typedef struct
   int base;
   /** encoding range size */
   int length;
+  /** word accumulator of the bit writer/reader */
+  uint64_t bit_buffer;
+  /** number of valid bits in bit_buffer */
+  int bit_count;
+  /** index of the next byte to be written/read by the word bit I/O */
+  size_t byte_index;
+  /** size of the output stream: bytes past it are counted in byte_index
+   *  but not written (SIZE_MAX unless set by encode_value_auto) */
+  size_t out_limit;
+  /** symbol lookup table used by decode_character (NULL if disabled),
+   *  entry i is the first symbol whose interval reaches the
+   *  i-th slot of the cumulative probability range */
+  uint16_t* decode_table;
+  /** log2 of the number of slots in decode_table */
+  int decode_bits;
+  /** caller-provided storage for decode_table (NULL if allocated) */
+  uint16_t* decode_storage;
+  /** the tables have been allocated by init_state (freed by ac_free_state) */
+  int owns_tables;
+  /** the tables are borrowed read-only (see init_state_with_model): only
+   *  static coding is allowed */
+  int read_only;
+  /** number of symbols coded between cumulative table updates
+   *  (0 for a static table) */
+  int update_range;
+  /** clear the occurence counts after each cumulative table update */
+  int range_clear;
+  /** number of symbols counted since the last update */
+  int update_count;
+  /** streaming phase: AC_STREAM_OFF (one-shot coding), AC_STREAM_START,
+   *  AC_STREAM_RUN or AC_STREAM_DONE */
+  int stream_phase;
+  /** digit and length of a run of digits waiting to be written
+   *  (streaming only) */
+  int run_digit;
+  int run_length;
+  /** digits produced after the pending run (streaming only) */
+  uint64_t tail_bits;
+  int tail_count;
+  /** binary range coder registers (see binary_coding): low value,
+   *  range size and decoder code value */
+  uint64_t bin_low;
+  uint32_t bin_range;
+  uint32_t bin_code;
+  /** binary range coder byte held back for carry propagation, followed
+   *  by bin_cache_size - 1 0xff bytes */
+  unsigned char bin_cache;
+  uint64_t bin_cache_size;
+#ifdef AC_STATS
+  /** coder statistics (see ac_get_stats) */
+  ac_stats_t stats;
+#endif
 
 } ac_state_t;
 
@@ -37,6 +141,51 @@ typedef struct
  */
 void init_state(ac_state_t* state, int precision);
 
+/** Initialize arithmetic coding state stucture for an alphabet of
+ *  @p alphabet_size symbols (coded with encode_symbol/decode_symbol,
+ *  init_state being equivalent to an alphabet of 256 symbols)
+ *  @p state structure to be initialized
+ *  @p precision fixed-point precision to used in computation, each symbol
+ *               needing 4 units: alphabet_size <= 1 << (precision - 2)
+ *  @p alphabet_size number of symbols (2 to AC_MAX_ALPHABET)
+ */
+void init_state_alphabet(ac_state_t* state, int precision, int alphabet_size);
+
+/** Initialize arithmetic coding state stucture with tables in caller
+ *  provided @p storage (no allocation is performed by the state, including
+ *  by enable_decode_lookup)
+ *  @p state structure to be initialized
+ *  @p precision fixed-point precision to used in computation
+ *  @p storage table storage, which must outlive the state
+ */
+void init_state_with_storage(ac_state_t* state, int precision, ac_storage_t* storage);
+
+/** Initialize arithmetic coding state stucture with caller-provided tables
+ *  (see init_state_with_storage)
+ *  @p state structure to be initialized
+ *  @p precision fixed-point precision to used in computation
+ *  @p prob_table probability table (256 entries)
+ *  @p cumul_table cumulative probability table (257 entries)
+ *  @p decode_storage storage for the lookup table ((1 << AC_LOOKUP_BITS) + 1
+ *                    entries), NULL to allocate it in enable_decode_lookup
+ */
+void init_state_with_tables(ac_state_t* state, int precision, int* prob_table,
+                            int* cumul_table, uint16_t* decode_storage);
+
+/** Reset @p state for reuse without allocation: coder registers, streaming
+ *  and update parameters and statistics are reinitialized and the
+ *  probability table is reset to uniform probabilities
+ *  @param state arithmetic coder state
+ */
+void ac_reset(ac_state_t* state);
+
+/** Release the tables allocated by init_state or enable_decode_lookup
+ *  (caller-provided storage is left untouched), @p state must be
+ *  initialized again before being used
+ *  @param state arithmetic coder state
+ */
+void ac_free_state(ac_state_t* state);
+
 /** build the probability table in @p state using a reference input
  *  @p state Arithmetic Coding state containing the probability table
  *  @p in    reference input to be used for probability init
@@ -44,6 +193,40 @@ void init_state(ac_state_t* state, int precision);
  */
 void build_probability_table(ac_state_t* state, const unsigned char* in, int size);
 
+/** maximal size (in bytes) of a serialized probability table header */
+#define AC_TABLE_HEADER_BOUND 256
+
+/** build the probability table in @p state from the occurences in @p in,
+ *  counts being quantized to 7 bits, and serialize it to @p out.
+ *  The header lists the quantized count (1 to 127) of each symbol, a run of
+ *  1 to 128 absent symbols being coded as a single byte 0x80 | (run - 1).
+ *  @param out output buffer (at least AC_TABLE_HEADER_BOUND bytes)
+ *  @param state Arithmetic Coding state containing the probability table
+ *  @param in    input to be used for probability init
+ *  @param size  number of byte to be read from @p in
+ *  @return header size (in bytes)
+ */
+size_t store_probability_table(unsigned char* out, ac_state_t* state,
+                               const unsigned char* in, size_t size);
+
+/** build the probability table in @p state from the occurence counts
+ *  @p count and serialize it to @p out (see store_probability_table)
+ *  @param out output buffer (at least AC_TABLE_HEADER_BOUND bytes)
+ *  @param state Arithmetic Coding state containing the probability table
+ *  @param count number of occurences of each byte value
+ *  @return header size (in bytes)
+ */
+size_t store_probability_counts(unsigned char* out, ac_state_t* state,
+                                const size_t count[256]);
+
+/** rebuild the probability table in @p state from a header generated by
+ *  store_probability_table
+ *  @param in    serialized probability table
+ *  @param state Arithmetic Coding state containing the probability table
+ *  @return header size (in bytes)
+ */
+size_t load_probability_table(const unsigned char* in, ac_state_t* state);
+
 /** Reset the probability table of the Arithmetic Coder state
  *  by giving equi-probable uniform probability to each byte
  *  @param state  arith coding state to reset
@@ -66,6 +249,37 @@ void transform_count_to_cumul(ac_state_t* state, int size);
  */
 void reset_prob_table(ac_state_t* state);
 
+/** Enable table-driven symbol lookup in decode_character: a slot to
+ *  symbol table (with at least two slots per symbol for alphabets
+ *  larger than 2^(AC_LOOKUP_BITS - 1)) is built from the cumulative probability table
+ *  and is kept up to date each time the cumulative table is rebuilt
+ *  (transform_count_to_cumul, build_probability_table and
+ *  reset_uniform_probability)
+ *  @param state arithmetic decoding state
+ */
+void enable_decode_lookup(ac_state_t* state);
+
+/** Rebuild the symbol lookup table of @p state from its cumulative
+ *  probability table (no-op if lookup is not enabled)
+ *  @param state arithmetic decoding state
+ */
+void build_decode_lookup(ac_state_t* state);
+
+/** Copy the statistics collected by @p state since its initialization
+ *  (or the last ac_reset_stats) to @p stats
+ *  @param state arithmetic coder state
+ *  @param stats output statistics (zeroed if statistics are disabled)
+ *  @return 1 if statistics are enabled (AC_STATS), 0 otherwise
+ */
+int ac_get_stats(const ac_state_t* state, ac_stats_t* stats);
+
+/** Reset the statistics of @p state */
+void ac_reset_stats(ac_state_t* state);
+
+/** Ideal (order-0 empirical entropy) cost in bits of the bytes counted in
+ *  @p stats, to be compared with stats->info_bits and the coded size */
+double ac_stats_entropy(const ac_stats_t* stats);
+
 /** Display the probability table of @p state */
 void display_prob_table(ac_state_t* state);
 
@@ -86,6 +300,31 @@ void encode_value(unsigned char* out, const unsigned char* in,
  */
 void encode_character(unsigned char* out, unsigned char in, ac_state_t* state);
 
+/** Arithmetic Coding of one symbol of the state alphabet
+ *  @p out byte array to be used as output stream
+ *  @p in  symbol to be coded (lower than state->alphabet_size)
+ *  @p state Arithmetic Coder state
+ */
+void encode_symbol(unsigned char* out, uint16_t in, ac_state_t* state);
+
+/** Initialize (reset) the coder registers and output stream of @p state
+ *  to start encoding a new value, the probability tables are kept
+ *  @param state internal arithmetic encoding state
+ */
+void init_encoding(ac_state_t* state);
+
+/** Arithmetic coding of a symbol given by its interval [@p cum_low,
+ *  @p cum_high) in a cumulative frequency distribution of total frequency
+ *  @p total (used by models which do not rely on the cumulative table)
+ *  @param out byte array to be used as output stream
+ *  @param state Arithmetic Coder state
+ *  @param cum_low cumulative frequency of the symbols preceding the symbol
+ *  @param cum_high @p cum_low plus the frequency of the symbol (> cum_low)
+ *  @param total total frequency (at most half of the state unit value)
+ */
+void encode_interval(unsigned char* out, ac_state_t* state, uint32_t cum_low,
+                     uint32_t cum_high, uint32_t total);
+
 /** Select a final numerical value to terminate encoding
  *  (flushing internal state)
  *  @param out output stream
@@ -93,6 +332,20 @@ void encode_character(unsigned char* out, unsigned char in, ac_state_t* state);
  */
 void select_value(unsigned char* out, ac_state_t* state);
 
+/** number of bytes the decoder may read past the end of a coded value: it
+ *  loads 64-bit words and its registers run up to precision - 2 bits ahead
+ *  of the encoder termination */
+#define AC_DECODE_PADDING 12
+
+/** Size of the output buffer of encode_value or encode_value_with_update
+ *  for @p size input bytes: upper bound on the number of bytes written,
+ *  plus AC_DECODE_PADDING bytes so that the value can be decoded in place
+ *  @param size number of input bytes
+ *  @param precision fixed-point precision of the coder state
+ *  @return maximal encoded size (in bytes)
+ */
+size_t encode_bound(size_t size, int precision);
+
 /** Initialize arithmetic coding state to decode @p in
  *  @param in input value buffer
  *  @param internal arithmetic decoding state to be initialized
@@ -106,13 +359,228 @@ void init_decoding(unsigned char* in, ac_state_t* state);
  */
 unsigned char decode_character( unsigned char* in, ac_state_t* state);
 
+/** Decode a single symbol of the state alphabet from the input buffer,
+ *  the search (and lookup table, see enable_decode_lookup) scaling with
+ *  the alphabet size
+ *  @param in input buffer (numerical encoded value)
+ *  @param state arithmetic decoding internal state
+ *  @return decoded symbol
+ */
+uint16_t decode_symbol(unsigned char* in, ac_state_t* state);
+
+/** Cumulative frequency target of the next symbol to be decoded: the
+ *  decoded symbol is the one whose interval [cum_low, cum_high) contains
+ *  the target, it must then be consumed with decode_interval
+ *  @param state arithmetic decoding state
+ *  @param total total frequency of the distribution used for encoding
+ *  @return cumulative frequency target (lower than @p total)
+ */
+uint32_t decode_target(ac_state_t* state, uint32_t total);
+
+/** Consume the symbol of interval [@p cum_low, @p cum_high) (see
+ *  encode_interval) from the decoding state
+ *  @param in input buffer (numerical encoded value)
+ *  @param state arithmetic decoding state
+ *  @param cum_low cumulative frequency of the symbols preceding the symbol
+ *  @param cum_high @p cum_low plus the frequency of the symbol
+ *  @param total total frequency of the distribution
+ */
+void decode_interval(unsigned char* in, ac_state_t* state, uint32_t cum_low,
+                     uint32_t cum_high, uint32_t total);
+
 /** Arithmetic decode the value in @p in according to the encoder defined
  *  by @p state, assuming @p
  *  expected_size characters should be decoded, writting them to @p out
+ *  The decoder reads @p in by 64-bit words and may access up to
+ *  AC_DECODE_PADDING bytes past the end of the encoded value (included in
+ *  encode_bound).
  */
 void decode_value(unsigned char* out, unsigned char* in, ac_state_t* state,
                   size_t expected_size);
 
+/** Self-describing static arithmetic coding of a byte-array: the
+ *  probability table is built from @p in and serialized ahead of the
+ *  coded value (see store_probability_table)
+ *  @param out byte-array used as output stream (at least
+ *             AC_TABLE_HEADER_BOUND + encode_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state (see init_state)
+ *  @return number of bytes written to @p out
+ */
+size_t encode_value_with_table(unsigned char* out, const unsigned char* in,
+                               size_t size, ac_state_t* state);
+
+/** Decoding of a byte-array generated by encode_value_with_table, the
+ *  probability table of @p state being rebuilt from the stream header
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array (header followed by the coded value)
+ *  @param state arithmetic decoder state (see init_state)
+ *  @param expected_size number of bytes to be decoded
+ */
+void decode_value_with_table(unsigned char* out, unsigned char* in,
+                             ac_state_t* state, size_t expected_size);
+
+/** maximal number of input bytes in the sample of estimate_coded_size */
+#define AC_SAMPLE_SIZE 4096
+
+/** minimal estimated gain (1 / AC_MIN_GAIN of the input size) for a
+ *  block to be coded by encode_value_auto, rather than stored raw */
+#define AC_MIN_GAIN 16
+
+/** block mode tags of encode_value_auto */
+#define AC_BLOCK_RAW   0
+#define AC_BLOCK_CODED 1
+
+/** Fast estimate of the order-0 coded size of @p in, from the histogram of
+ *  a sample of at most AC_SAMPLE_SIZE bytes (runs spread over the input)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @return estimated coded size (in bytes)
+ */
+size_t estimate_coded_size(const unsigned char* in, size_t size);
+
+/** Raw-store decision of encode_value_auto: whether the estimated coded
+ *  size of @p in (see estimate_coded_size) saves at least 1 / AC_MIN_GAIN
+ *  of its @p size bytes
+ *  @return 1 if the block is worth coding, 0 otherwise
+ */
+int estimate_compressible(const unsigned char* in, size_t size);
+
+/** Store @p size bytes of @p in as an AC_BLOCK_RAW block (tag followed by
+ *  the bytes)
+ *  @return number of bytes written to @p out (@p size + 1)
+ */
+size_t store_value_raw(unsigned char* out, const unsigned char* in, size_t size);
+
+/** Size of the output buffer of encode_value_auto for @p size input bytes
+ *  (the block mode tag followed by at most @p size bytes), a coded block
+ *  leaving at least AC_DECODE_PADDING bytes of it unused */
+size_t auto_bound(size_t size);
+
+/** Adaptive arithmetic coding of a byte-array (see encode_value_with_update)
+ *  with a raw-store fallback: the output starts with a block mode tag,
+ *  AC_BLOCK_RAW if the input is estimated incompressible (see
+ *  estimate_coded_size, the coder is not run) or its coded value reaches
+ *  @p size - AC_DECODE_PADDING bytes (the coder then stops), AC_BLOCK_CODED
+ *  otherwise.
+ *  @param out byte-array used as output stream (at least auto_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state, reset before coding
+ *  @param update_range number of input byte encoded between cumulative
+ *                      probability update
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ *  @return number of bytes written to @p out (at most @p size + 1)
+ */
+size_t encode_value_auto(unsigned char* out, const unsigned char* in, size_t size,
+                         ac_state_t* state, int update_range, int range_clear);
+
+/** Decoding of a byte-array generated by encode_value_auto with the same
+ *  parameters (coded blocks may be read up to AC_DECODE_PADDING bytes past
+ *  their end, within auto_bound bytes of @p in)
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array (block mode tag followed by the raw bytes or
+ *            the coded value)
+ *  @param state arithmetic decoder state
+ *  @param expected_size number of bytes to be decoded
+ *  @param update_range number of input byte encoded between cumulative
+ *                      probability update
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ */
+void decode_value_auto(unsigned char* out, unsigned char* in, ac_state_t* state,
+                       size_t expected_size, int update_range, int range_clear);
+
+/** maximal number of lanes of the interleaved coder */
+#define AC_MAX_LANES 8
+
+/** Arithmetic coding of a byte-array split into @p lanes independent
+ *  coders sharing the static probability table of @p state, symbol i being
+ *  coded by lane (i % lanes).
+ *  The output stream is made of the lane count (1 byte), the byte sizes of
+ *  the first lanes - 1 coded values (4 bytes each, most significant byte
+ *  first) followed by the concatenation of the lanes coded values.
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state (parameters + probability table)
+ *  @param lanes number of lanes (2, 4 or 8)
+ *  @return number of bytes written to @p out
+ */
+size_t encode_value_interleaved(unsigned char* out, const unsigned char* in,
+                                size_t size, ac_state_t* state, int lanes);
+
+/** Arithmetic decoding of an interleaved stream generated by
+ *  encode_value_interleaved with the same probability table; the lanes
+ *  being independent, their decoding is overlapped
+ *  @param out byte-array used as output stream
+ *  @param in interleaved input stream
+ *  @param state arithmetic decoder state (parameters + probability table)
+ *  @param expected_size number of bytes to be decoded
+ */
+void decode_value_interleaved(unsigned char* out, unsigned char* in,
+                              ac_state_t* state, size_t expected_size);
+
+/** Streaming phases */
+#define AC_STREAM_OFF   0
+#define AC_STREAM_START 1
+#define AC_STREAM_RUN   2
+#define AC_STREAM_DONE  3
+
+/** Initialize @p state for incremental (streaming) encoding or decoding
+ *  with ac_encode_stream/ac_decode_stream. The coder and model state
+ *  are kept in @p state between calls, memory usage does not depend on
+ *  the stream size.
+ *  @param state arithmetic coder state
+ *  @param update_range number of symbols coded between cumulative
+ *                      probability updates, 0 to code with the current
+ *                      (static) table of @p state; else the table is reset
+ *                      to uniform probabilities
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ */
+void init_stream(ac_state_t* state, int update_range, int range_clear);
+
+/** Incremental arithmetic coding: encode as much of @p in as fits in @p out.
+ *  The encoded stream is identical to the one generated by encode_value
+ *  (static table) or encode_value_with_update with the same parameters.
+ *  @param state streaming state (see init_stream)
+ *  @param in next input bytes
+ *  @param in_len number of bytes in @p in
+ *  @param out output buffer for this call
+ *  @param out_cap number of bytes available in @p out
+ *  @param consumed set to the number of bytes consumed from @p in
+ *  @param produced set to the number of bytes written to @p out
+ *  @param flush non-zero if @p in is the end of the input: the coded value
+ *               is terminated once all of it has been consumed
+ *  @return 1 once the terminated coded value has been completely written,
+ *          0 if more input or output space is required
+ */
+int ac_encode_stream(ac_state_t* state, const unsigned char* in, size_t in_len,
+                     unsigned char* out, size_t out_cap,
+                     size_t* consumed, size_t* produced, int flush);
+
+/** Incremental arithmetic decoding: decode as many bytes as fit in @p out
+ *  from the encoded bytes provided so far. The number of bytes of the
+ *  original input is not stored: the caller stops once it has received
+ *  all of them.
+ *  @param state streaming state (see init_stream)
+ *  @param in next encoded bytes
+ *  @param in_len number of bytes in @p in
+ *  @param out output buffer for this call
+ *  @param out_cap number of bytes available in @p out
+ *  @param consumed set to the number of bytes consumed from @p in
+ *  @param produced set to the number of bytes written to @p out
+ *  @param flush non-zero if @p in is the end of the encoded stream
+ *               (missing digits are then read as zeros)
+ *  @return 1 if @p out has been filled, 0 if more encoded bytes are required
+ */
+int ac_decode_stream(ac_state_t* state, const unsigned char* in, size_t in_len,
+                     unsigned char* out, size_t out_cap,
+                     size_t* consumed, size_t* produced, int flush);
+
 /** Arihtmetic coding of a byte-array with regular update to the probability
  *  table (initialized to uniform probabilities)
  *  @param out byte-array used as output stream for the numerical code value
@@ -143,4 +611,99 @@ void decode_value_with_update(unsigned char* out, unsigned char* in,
                               ac_state_t* state, size_t expected_size,
                               int update_range, int range_clear);
 
+/** build the probability table of @p state (of any alphabet size) from
+ *  the occurences of the symbols of @p in
+ *  @param state Arithmetic Coding state containing the probability table
+ *  @param in reference symbols
+ *  @param size number of symbols in @p in
+ */
+void build_symbol_table(ac_state_t* state, const uint16_t* in, size_t size);
+
+/** Static arithmetic coding of a symbol array with the current table of
+ *  @p state (see build_symbol_table)
+ *  @param out byte-array used as output stream
+ *  @param in input symbols
+ *  @param size number of symbols in @p in
+ *  @param state arithmetic coder state (see init_state_alphabet)
+ */
+void encode_symbols(unsigned char* out, const uint16_t* in, size_t size,
+                    ac_state_t* state);
+
+/** Decoding of a symbol array generated by encode_symbols with the same
+ *  table
+ *  @param out output symbols
+ *  @param in input byte-array containing the numerical code value
+ *  @param state arithmetic coder state
+ *  @param expected_size number of symbols to be decoded
+ */
+void decode_symbols(uint16_t* out, unsigned char* in, ac_state_t* state,
+                    size_t expected_size);
+
+/** Adaptive arithmetic coding of a symbol array (see
+ *  encode_value_with_update), the table rebuild cost being proportional
+ *  to the alphabet size @p update_range should grow with it
+ *  @param out byte-array used as output stream
+ *  @param in input symbols
+ *  @param size number of symbols in @p in
+ *  @param state arithmetic coder state (see init_state_alphabet)
+ *  @param update_range number of symbols coded between cumulative
+ *                      probability updates
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ */
+void encode_symbols_with_update(unsigned char* out, const uint16_t* in,
+                                size_t size, ac_state_t* state,
+                                int update_range, int range_clear);
+
+/** Decoding of a symbol array generated by encode_symbols_with_update
+ *  with the same parameters
+ *  @param out output symbols
+ *  @param in input byte-array containing the numerical code value
+ *  @param state arithmetic coder state (see init_state_alphabet)
+ *  @param expected_size number of symbols to be decoded
+ *  @param update_range number of symbols coded between cumulative
+ *                      probability updates
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ */
+void decode_symbols_with_update(uint16_t* out, unsigned char* in,
+                                ac_state_t* state, size_t expected_size,
+                                int update_range, int range_clear);
+
+/** Adaptive arithmetic coding of a byte-array with a power-of-two total
+ *  model: the cumulative table always sums to 1 << state->frac_size (it is
+ *  reset to uniform probabilities first) and it is rebuilt every
+ *  1 << @p window_bits symbols without any division, each frequency being
+ *  decayed by 1 / 2^@p decay_shift and the decayed mass being given to the
+ *  symbols of the window in proportion to their counts (each symbol keeps
+ *  a frequency of at least 2). Contrary to range_clear, statistics are
+ *  forgotten progressively.
+ *  @param out byte-array used as output stream for the numerical code value
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state (parameter + internal state)
+ *  @param window_bits log2 of the number of symbols coded between updates
+ *                     (at most the state precision)
+ *  @param decay_shift adaptation rate, from 0 (everything but the last
+ *                     window is forgotten) to 16; rounding limits the
+ *                     decay of frequencies lower than 2^decay_shift, it
+ *                     should stay well below precision - 8
+ */
+void encode_value_with_decay(unsigned char* out, const unsigned char* in,
+                             size_t size, ac_state_t* state, int window_bits,
+                             int decay_shift);
+
+/** Decoding of a byte-array generated by encode_value_with_decay with the
+ *  same parameters
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array containing the numerical code value
+ *  @param state arithmetic coder state (parameter + internal state)
+ *  @param expected_size number of bytes expected to be decoded in @p in
+ *  @param window_bits log2 of the number of symbols coded between updates
+ *  @param decay_shift adaptation rate
+ */
+void decode_value_with_decay(unsigned char* out, unsigned char* in,
+                             ac_state_t* state, size_t expected_size,
+                             int window_bits, int decay_shift);
+
 /** @} */
@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "batch_coding.h"
+
+size_t batch_bound(const ac_record_t* records, size_t count, int precision)
+{
+  // the decoder read-ahead is only budgeted once, past the last record
+  size_t bound = AC_TABLE_HEADER_BOUND + AC_DECODE_PADDING;
+  size_t i;
+
+  for (i = 0; i < count; ++i) bound += encode_bound(records[i].size, precision) - AC_DECODE_PADDING;
+
+  return bound;
+}
+
+size_t encode_batch(unsigned char* out, const ac_record_t* records, size_t count,
+                    ac_state_t* state, size_t* offsets)
+{
+  size_t byte_count[256] = {0};
+  size_t i, j;
+
+  // one table for the whole batch (records are too small for a histogram
+  // pass of their own to pay off)
+  for (i = 0; i < count; ++i) {
+    for (j = 0; j < records[i].size; ++j) byte_count[records[i].data[j]]++;
+  }
+  offsets[0] = store_probability_counts(out, state, byte_count);
+
+  for (i = 0; i < count; ++i) {
+    size_t size = records[i].size;
+    offsets[i + 1] = offsets[i];
+    if (!size) continue;
+
+    // only the coder registers are reset between records
+    init_encoding(state);
+    for (j = 0; j < size; ++j) encode_character(out + offsets[i], records[i].data[j], state);
+    select_value(out + offsets[i], state);
+    offsets[i + 1] += state->byte_index;
+  }
+
+  return offsets[count];
+}
+
+void decode_batch_record(unsigned char* out, unsigned char* in, const size_t* offsets,
+                         size_t index, size_t size, ac_state_t* state)
+{
+  if (!size) return;
+  assert(offsets[index + 1] > offsets[index] && "invalid record offsets");
+
+  decode_value(out, in + offsets[index], state, size);
+}
+
+void decode_batch(unsigned char* out, unsigned char* in, const size_t* offsets,
+                  const size_t* sizes, size_t count, ac_state_t* state)
+{
+  size_t header_size = load_probability_table(in, state);
+  size_t i;
+
+  assert(header_size == offsets[0] && "invalid batch header");
+
+  for (i = 0; i < count; ++i) {
+    decode_batch_record(out, in, offsets, i, sizes[i], state);
+    out += sizes[i];
+  }
+}
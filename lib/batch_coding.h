@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "arith_coding.h"
+
+/** \defgroup batch_coding batch coding
+ *  \brief Coding of many small records against one shared static model
+ *   @{
+ */
+
+/** Record (message) of a batch */
+typedef struct
+{
+  /** record bytes */
+  const unsigned char* data;
+  /** number of bytes in data */
+  size_t size;
+} ac_record_t;
+
+/** Upper bound on the size of the batch generated by encode_batch, plus
+ *  the AC_DECODE_PADDING bytes read past the last record by its decoding
+ *  @param records records of the batch
+ *  @param count number of records
+ *  @param precision fixed-point precision of the coder state
+ *  @return maximal encoded size (in bytes)
+ */
+size_t batch_bound(const ac_record_t* records, size_t count, int precision);
+
+/** Static arithmetic coding of @p count records with a single probability
+ *  table built from all of them. The output is the serialized table (see
+ *  store_probability_counts) followed by one coded value per record, each
+ *  record being terminated (byte-aligned) so that it can be decoded on its
+ *  own; an empty record is coded with no byte at all.
+ *  Record i is coded in out[offsets[i] .. offsets[i + 1]), offsets[0]
+ *  being the size of the table header.
+ *  @param out output buffer, at least batch_bound() bytes
+ *  @param records records to be coded
+ *  @param count number of records
+ *  @param state arithmetic coder state (see init_state)
+ *  @param offsets output table of @p count + 1 offsets in @p out
+ *  @return number of bytes written to @p out (offsets[count])
+ */
+size_t encode_batch(unsigned char* out, const ac_record_t* records, size_t count,
+                    ac_state_t* state, size_t* offsets);
+
+/** Decoding of record @p index of a batch generated by encode_batch, the
+ *  probability table of @p state must have been loaded from the batch
+ *  header with load_probability_table (it can be shared by any number of
+ *  record decodings). The decoder may read up to AC_DECODE_PADDING bytes
+ *  past the end of the record, @p in must be batch_bound bytes long.
+ *  @param out output buffer (@p size bytes)
+ *  @param in encoded batch
+ *  @param offsets record offsets returned by encode_batch
+ *  @param index index of the record to be decoded
+ *  @param size number of bytes in the record
+ *  @param state arithmetic decoder state
+ */
+void decode_batch_record(unsigned char* out, unsigned char* in, const size_t* offsets,
+                         size_t index, size_t size, ac_state_t* state);
+
+/** Decoding of all the records of a batch generated by encode_batch,
+ *  records being written one after the other to @p out
+ *  @param out output buffer (sum of @p sizes bytes)
+ *  @param in encoded batch
+ *  @param offsets record offsets returned by encode_batch
+ *  @param sizes number of bytes in each record
+ *  @param count number of records
+ *  @param state arithmetic decoder state (see init_state)
+ */
+void decode_batch(unsigned char* out, unsigned char* in, const size_t* offsets,
+                  const size_t* sizes, size_t count, ac_state_t* state);
+
+/** @} */
@@ -0,0 +1,140 @@
+#include "binary_coding.h"
+
+/** the range is renormalized (by bytes) once it falls below RANGE_TOP */
+#define RANGE_TOP (1u << 24)
+
+/** Shift the top byte of the low register out of @p state, bytes being
+ *  held back as long as a carry may still reach them */
+static void shift_low(unsigned char* out, ac_state_t* state)
+{
+  if ((uint32_t) state->bin_low < 0xff000000u || (state->bin_low >> 32) != 0) {
+    unsigned char carry = (unsigned char) (state->bin_low >> 32);
+    unsigned char byte  = state->bin_cache;
+    do {
+      out[state->byte_index++] = byte + carry;
+      byte = 0xff;
+    } while (--state->bin_cache_size != 0);
+    state->bin_cache = (unsigned char) (state->bin_low >> 24);
+  }
+  state->bin_cache_size++;
+  state->bin_low = (state->bin_low & 0x00ffffffu) << 8;
+}
+
+/** Code @p bit with the probability of 0 @p prob (updated) */
+static inline void encode_bit(unsigned char* out, ac_state_t* state, int* prob, int bit)
+{
+  uint32_t bound = (state->bin_range >> BIN_PROB_BITS) * (uint32_t) *prob;
+
+  if (bit) {
+    state->bin_low   += bound;
+    state->bin_range -= bound;
+    *prob -= *prob >> BIN_MOVE_BITS;
+  } else {
+    state->bin_range = bound;
+    *prob += ((1 << BIN_PROB_BITS) - *prob) >> BIN_MOVE_BITS;
+  }
+
+  while (state->bin_range < RANGE_TOP) {
+    state->bin_range <<= 8;
+    shift_low(out, state);
+  }
+}
+
+/** Decode a bit with the probability of 0 @p prob (updated) */
+static inline int decode_bit(const unsigned char* in, ac_state_t* state, int* prob)
+{
+  uint32_t bound = (state->bin_range >> BIN_PROB_BITS) * (uint32_t) *prob;
+  int bit;
+
+  if (state->bin_code < bound) {
+    state->bin_range = bound;
+    *prob += ((1 << BIN_PROB_BITS) - *prob) >> BIN_MOVE_BITS;
+    bit = 0;
+  } else {
+    state->bin_code  -= bound;
+    state->bin_range -= bound;
+    *prob -= *prob >> BIN_MOVE_BITS;
+    bit = 1;
+  }
+
+  while (state->bin_range < RANGE_TOP) {
+    state->bin_range <<= 8;
+    state->bin_code = (state->bin_code << 8) | in[state->byte_index++];
+  }
+
+  return bit;
+}
+
+size_t binary_bound(size_t size)
+{
+  // the adaptive probabilities keep the cost of a byte close to 8 bits even
+  // on adversarial inputs (about 2.5% expansion), plus 5 flush bytes
+  return size + size / 8 + 5;
+}
+
+void reset_binary_probability(ac_state_t* state)
+{
+  int i;
+  for (i = 0; i < 256; ++i) state->prob_table[i] = 1 << (BIN_PROB_BITS - 1);
+}
+
+void binary_encode_character(unsigned char* out, unsigned char in, ac_state_t* state)
+{
+  int node = 1;
+  int i;
+
+  // bit-tree: the node of each bit is given by the previous bits of the byte
+  for (i = 7; i >= 0; --i) {
+    int bit = (in >> i) & 1;
+    encode_bit(out, state, state->prob_table + node, bit);
+    node = (node << 1) | bit;
+  }
+}
+
+void binary_flush(unsigned char* out, ac_state_t* state)
+{
+  int i;
+  for (i = 0; i < 5; ++i) shift_low(out, state);
+}
+
+void init_binary_decoding(const unsigned char* in, ac_state_t* state)
+{
+  int i;
+
+  init_encoding(state);
+  // the first byte (cache initial value) is always 0
+  for (i = 0; i < 5; ++i) state->bin_code = (state->bin_code << 8) | in[state->byte_index++];
+}
+
+unsigned char binary_decode_character(const unsigned char* in, ac_state_t* state)
+{
+  int node = 1;
+
+  while (node < 256) node = (node << 1) | decode_bit(in, state, state->prob_table + node);
+
+  return (unsigned char) node;
+}
+
+size_t encode_value_binary(unsigned char* out, const unsigned char* in, size_t size, ac_state_t* state)
+{
+  size_t i;
+
+  init_encoding(state);
+  reset_binary_probability(state);
+
+  for (i = 0; i < size; ++i) binary_encode_character(out, in[i], state);
+
+  binary_flush(out, state);
+
+  return state->byte_index;
+}
+
+void decode_value_binary(unsigned char* out, const unsigned char* in, ac_state_t* state, size_t expected_size)
+{
+  size_t i;
+
+  reset_binary_probability(state);
+  init_binary_decoding(in, state);
+
+  for (i = 0; i < expected_size; ++i) out[i] = binary_decode_character(in, state);
+}
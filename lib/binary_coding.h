@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "arith_coding.h"
+
+/** \defgroup binary_coding adaptive binary coding
+ *  \brief Byte coding as 8 binary decisions through a bit-tree of adaptive
+ *         probabilities, with a byte-oriented range coder
+ *   @{
+ */
+
+/** number of bits of the binary probabilities */
+#define BIN_PROB_BITS 12
+/** adaptation speed: probabilities move by 1/2^BIN_MOVE_BITS of their
+ *  distance to the coded bit */
+#define BIN_MOVE_BITS 5
+
+/** Upper bound on the number of bytes written by encode_value_binary
+ *  @param size number of input bytes
+ *  @return maximal encoded size (in bytes)
+ */
+size_t binary_bound(size_t size);
+
+/** Reset the bit-tree probabilities of @p state to 1/2, the bit-tree nodes
+ *  (1 to 255) being stored in the probability table
+ *  @param state arithmetic coder state
+ */
+void reset_binary_probability(ac_state_t* state);
+
+/** Binary coding of one byte through the bit-tree of @p state, the node
+ *  probabilities being updated
+ *  @param out byte array to be used as output stream
+ *  @param in byte to be coded
+ *  @param state arithmetic coder state
+ */
+void binary_encode_character(unsigned char* out, unsigned char in, ac_state_t* state);
+
+/** Flush the binary range coder of @p state (terminating the coded value)
+ *  @param out byte array to be used as output stream
+ *  @param state arithmetic coder state
+ */
+void binary_flush(unsigned char* out, ac_state_t* state);
+
+/** Initialize the binary range decoder of @p state to decode @p in */
+void init_binary_decoding(const unsigned char* in, ac_state_t* state);
+
+/** Binary decoding of one byte through the bit-tree of @p state, the node
+ *  probabilities being updated
+ *  @param in input buffer
+ *  @param state arithmetic decoding state
+ *  @return decoded byte value
+ */
+unsigned char binary_decode_character(const unsigned char* in, ac_state_t* state);
+
+/** Adaptive binary coding of a byte-array, the bit-tree probabilities of
+ *  @p state (see init_state) being reset before coding
+ *  @param out byte-array used as output stream (at least binary_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state
+ *  @return number of bytes written to @p out
+ */
+size_t encode_value_binary(unsigned char* out, const unsigned char* in,
+                           size_t size, ac_state_t* state);
+
+/** Adaptive binary decoding of a byte-array generated by
+ *  encode_value_binary (the decoder does not read past the end of the
+ *  coded value)
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array
+ *  @param state arithmetic coder state
+ *  @param expected_size number of bytes to be decoded
+ */
+void decode_value_binary(unsigned char* out, const unsigned char* in,
+                         ac_state_t* state, size_t expected_size);
+
+/** @} */
@@ -0,0 +1,285 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "arith_coding.h"
+#include "block_coding.h"
+
+/** Block-parallel job shared by the worker threads */
+typedef struct block_job
+{
+  /** output buffer */
+  unsigned char* out;
+  /** input buffer */
+  const unsigned char* in;
+  /** number of (decoded) bytes */
+  size_t size;
+  /** number of (decoded) bytes per block */
+  size_t block_size;
+  /** number of blocks */
+  size_t block_count;
+  /** position of each encoded block in the encoded buffer */
+  size_t* offsets;
+  /** size of each encoded block */
+  size_t* encoded_sizes;
+  /** coder parameters */
+  int precision;
+  int update_range;
+  int range_clear;
+  /** index of the next block to be processed */
+  size_t next_block;
+  /** lock protecting next_block */
+  pthread_mutex_t lock;
+  /** block processing function */
+  void (*process)(struct block_job* job, size_t block);
+} block_job_t;
+
+/** Store a 32-bit value in @p out, most significant byte first */
+static void store_u32(unsigned char* out, size_t value)
+{
+  assert(value <= 0xffffffff && "value exceeds container field");
+  out[0] = (unsigned char) (value >> 24);
+  out[1] = (unsigned char) (value >> 16);
+  out[2] = (unsigned char) (value >> 8);
+  out[3] = (unsigned char) value;
+}
+
+/** Load a 32-bit value from @p in, most significant byte first */
+static size_t load_u32(const unsigned char* in)
+{
+  return ((size_t) in[0] << 24) | ((size_t) in[1] << 16) | ((size_t) in[2] << 8) | in[3];
+}
+
+/** Number of (decoded) bytes in block @p block of @p job */
+static size_t job_block_size(block_job_t* job, size_t block)
+{
+  size_t start = block * job->block_size;
+  return job->size - start < job->block_size ? job->size - start : job->block_size;
+}
+
+static void encode_block(block_job_t* job, size_t block)
+{
+  ac_state_t state;
+  ac_storage_t storage;
+
+  init_state_with_storage(&state, job->precision, &storage);
+  job->encoded_sizes[block] = encode_value_auto(job->out + job->offsets[block],
+                                                job->in + block * job->block_size,
+                                                job_block_size(job, block), &state,
+                                                job->update_range, job->range_clear);
+}
+
+/** Decode the @p size bytes of an encoded block @p in (@p coded_size
+ *  bytes, @p available bytes being readable from @p in) to @p out */
+static void decode_block_value(unsigned char* out, const unsigned char* in, size_t size,
+                               size_t coded_size, size_t available, int precision,
+                               int update_range, int range_clear)
+{
+  ac_state_t state;
+  ac_storage_t storage;
+
+  init_state_with_storage(&state, precision, &storage);
+
+  // the decoder reads up to AC_DECODE_PADDING bytes past a coded block: a
+  // block too close to the end of the container is decoded from a padded copy
+  if (in[0] == AC_BLOCK_CODED && available - coded_size < AC_DECODE_PADDING) {
+    unsigned char* padded = calloc(coded_size + AC_DECODE_PADDING, 1);
+    assert(padded && "memory allocation failed");
+    memcpy(padded, in, coded_size);
+    decode_value_auto(out, padded, &state, size, update_range, range_clear);
+    free(padded);
+    return;
+  }
+
+  decode_value_auto(out, (unsigned char*) in, &state, size, update_range, range_clear);
+}
+
+static void decode_block(block_job_t* job, size_t block)
+{
+  decode_block_value(job->out + block * job->block_size, job->in + job->offsets[block],
+                     job_block_size(job, block), job->offsets[block + 1] - job->offsets[block],
+                     job->offsets[job->block_count] - job->offsets[block], job->precision,
+                     job->update_range, job->range_clear);
+}
+
+/** Worker thread: process blocks until none is left */
+static void* block_worker(void* arg)
+{
+  block_job_t* job = arg;
+
+  while (1) {
+    pthread_mutex_lock(&job->lock);
+    size_t block = job->next_block++;
+    pthread_mutex_unlock(&job->lock);
+
+    if (block >= job->block_count) return NULL;
+    job->process(job, block);
+  }
+}
+
+/** Process all the blocks of @p job with @p threads threads (the calling
+ *  thread being one of them) */
+static void run_job(block_job_t* job, int threads)
+{
+  int i;
+
+  if (threads <= 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if ((size_t) threads > job->block_count) threads = (int) job->block_count;
+  if (threads < 1) threads = 1;
+
+  pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+  assert(workers && "memory allocation failed");
+
+  job->next_block = 0;
+  pthread_mutex_init(&job->lock, NULL);
+
+  // blocks are shared through next_block: if a thread can not be
+  // created, its blocks are processed by the started ones
+  int started = 1;
+  while (started < threads && !pthread_create(workers + started, NULL, block_worker, job)) started++;
+  block_worker(job);
+  for (i = 1; i < started; ++i) pthread_join(workers[i], NULL);
+
+  pthread_mutex_destroy(&job->lock);
+  free(workers);
+}
+
+size_t parallel_bound(size_t size, size_t block_size)
+{
+  size_t block_count = (size + block_size - 1) / block_size;
+  return BLOCK_HEADER_SIZE(block_count) + block_count * auto_bound(block_size);
+}
+
+size_t encode_parallel(unsigned char* out, const unsigned char* in, size_t size,
+                       size_t block_size, int precision, int update_range,
+                       int range_clear, int threads)
+{
+  assert(block_size > 0 && "block size must be positive");
+
+  block_job_t job;
+  size_t block;
+
+  job.out = out;
+  job.in  = in;
+  job.size = size;
+  job.block_size  = block_size;
+  job.block_count = (size + block_size - 1) / block_size;
+  job.precision    = precision;
+  job.update_range = update_range;
+  job.range_clear  = range_clear;
+  job.process = encode_block;
+
+  job.offsets       = malloc(sizeof(size_t) * (job.block_count + 1));
+  job.encoded_sizes = malloc(sizeof(size_t) * (job.block_count + 1));
+  assert(job.offsets && job.encoded_sizes && "memory allocation failed");
+
+  // each block is first encoded in its own worst-case sized slot
+  size_t header_size = BLOCK_HEADER_SIZE(job.block_count);
+  size_t slot_size   = auto_bound(block_size);
+  for (block = 0; block < job.block_count; ++block) job.offsets[block] = header_size + block * slot_size;
+
+  run_job(&job, threads);
+
+  // header and blocks compaction
+  size_t offset = header_size;
+  store_u32(out, block_size);
+  store_u32(out + 4, job.block_count);
+  for (block = 0; block < job.block_count; ++block) {
+    memmove(out + offset, out + job.offsets[block], job.encoded_sizes[block]);
+    store_u32(out + 8 + 4 * block, job.encoded_sizes[block]);
+    offset += job.encoded_sizes[block];
+  }
+
+  free(job.offsets);
+  free(job.encoded_sizes);
+
+  return offset;
+}
+
+void decode_parallel(unsigned char* out, const unsigned char* in,
+                     size_t expected_size, int precision, int update_range,
+                     int range_clear, int threads)
+{
+  block_job_t job;
+  size_t block;
+
+  job.out = out;
+  job.in  = in;
+  job.size = expected_size;
+  job.block_size  = load_u32(in);
+  job.block_count = load_u32(in + 4);
+  job.precision    = precision;
+  job.update_range = update_range;
+  job.range_clear  = range_clear;
+  job.process = decode_block;
+  job.encoded_sizes = NULL;
+
+  assert(job.block_size > 0 && job.block_count == (expected_size + job.block_size - 1) / job.block_size &&
+         "container does not match expected size");
+
+  job.offsets = malloc(sizeof(size_t) * (job.block_count + 1));
+  assert(job.offsets && "memory allocation failed");
+
+  job.offsets[0] = BLOCK_HEADER_SIZE(job.block_count);
+  for (block = 0; block < job.block_count; ++block) {
+    job.offsets[block + 1] = job.offsets[block] + load_u32(in + 8 + 4 * block);
+  }
+
+  run_job(&job, threads);
+
+  free(job.offsets);
+}
+
+void decode_range(unsigned char* out, const unsigned char* in, size_t expected_size,
+                  size_t offset, size_t length, int precision, int update_range,
+                  int range_clear)
+{
+  size_t block_size  = load_u32(in);
+  size_t block_count = load_u32(in + 4);
+  size_t block;
+
+  assert(block_size > 0 && block_count == (expected_size + block_size - 1) / block_size &&
+         "container does not match expected size");
+  assert(offset <= expected_size && length <= expected_size - offset && "range exceeds decoded size");
+  if (!length) return;
+
+  size_t first = offset / block_size;
+  size_t last  = (offset + length - 1) / block_size;
+
+  // position of the first block and end of the container: the encoded
+  // sizes of the other blocks are only summed, none of them is decoded
+  size_t position = BLOCK_HEADER_SIZE(block_count), container_end;
+  for (block = 0; block < first; ++block) position += load_u32(in + 8 + 4 * block);
+  for (container_end = position; block < block_count; ++block) container_end += load_u32(in + 8 + 4 * block);
+
+  unsigned char* buffer = NULL;
+
+  for (block = first; block <= last; ++block) {
+    size_t start = block * block_size;
+    size_t size  = expected_size - start < block_size ? expected_size - start : block_size;
+    size_t begin = block == first ? offset - start : 0;
+    size_t end   = block == last ? offset + length - start : size;
+    size_t coded_size = load_u32(in + 8 + 4 * block);
+
+    if (begin == 0 && end == size) {
+      // block entirely in the range: decoded in place
+      decode_block_value(out, in + position, size, coded_size, container_end - position, precision,
+                         update_range, range_clear);
+    } else {
+      if (!buffer) buffer = malloc(block_size);
+      assert(buffer && "memory allocation failed");
+      decode_block_value(buffer, in + position, size, coded_size, container_end - position, precision,
+                         update_range, range_clear);
+      memcpy(out, buffer + begin, end - begin);
+    }
+
+    out += end - begin;
+    position += coded_size;
+  }
+
+  free(buffer);
+}
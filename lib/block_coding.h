@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+
+/** \defgroup block_coding block-parallel coding
+ *  \brief Multithreaded encoding and decoding of independent blocks
+ *   @{
+ */
+
+/** Size of the framed container header for @p block_count blocks:
+ *  block size (4 bytes), block count (4 bytes) and the encoded size of
+ *  each block (4 bytes each), all most significant byte first */
+#define BLOCK_HEADER_SIZE(block_count) (8 + 4 * (size_t) (block_count))
+
+/** Size of the output buffer of encode_parallel (blocks being coded in
+ *  their own slot of auto_bound bytes before they are compacted):
+ *  BLOCK_HEADER_SIZE + size + one byte per block
+ *  @param size number of input bytes
+ *  @param block_size number of input bytes per block
+ *  @return maximal container size (in bytes)
+ */
+size_t parallel_bound(size_t size, size_t block_size);
+
+/** Adaptive arithmetic coding (encode_value_auto) of @p in split
+ *  into independent blocks of @p block_size bytes, each block being coded
+ *  with its own state by a pool of @p threads worker threads, or stored
+ *  raw if it is incompressible (see the block mode tags).
+ *  The output is a framed container made of a header (see
+ *  BLOCK_HEADER_SIZE) followed by the encoded blocks, each starting with
+ *  its block mode tag (see encode_value_auto).
+ *  @param out output buffer, at least parallel_bound() bytes
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param block_size number of input bytes per block
+ *  @param precision fixed-point precision of the block coders
+ *  @param update_range number of input byte encoded between cumulative
+ *                      probability update
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ *  @param threads number of worker threads (0 for one per online CPU)
+ *  @return size of the container (in bytes)
+ */
+size_t encode_parallel(unsigned char* out, const unsigned char* in, size_t size,
+                       size_t block_size, int precision, int update_range,
+                       int range_clear, int threads);
+
+/** Decoding of a framed container generated by encode_parallel, blocks
+ *  being decoded by a pool of @p threads worker threads.
+ *  Coder parameters must be identical to the ones used for encoding.
+ *  @param out output buffer (@p expected_size bytes)
+ *  @param in framed container (not read past its end)
+ *  @param expected_size number of bytes to be decoded
+ *  @param precision fixed-point precision of the block coders
+ *  @param update_range number of input byte encoded between cumulative
+ *                      probability update
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ *  @param threads number of worker threads (0 for one per online CPU)
+ */
+void decode_parallel(unsigned char* out, const unsigned char* in,
+                     size_t expected_size, int precision, int update_range,
+                     int range_clear, int threads);
+
+/** Random-access decoding of the bytes [@p offset, @p offset + @p length)
+ *  of a framed container generated by encode_parallel: only the blocks
+ *  overlapping the range are decoded (by the calling thread).
+ *  Coder parameters must be identical to the ones used for encoding.
+ *  @param out output buffer (@p length bytes)
+ *  @param in framed container (not read past its end)
+ *  @param expected_size total number of bytes in the container
+ *  @param offset position of the first byte to be decoded
+ *  @param length number of bytes to be decoded
+ *  @param precision fixed-point precision of the block coders
+ *  @param update_range number of input byte encoded between cumulative
+ *                      probability update
+ *  @param range_clear enable(1) / disable(0) the clear of probability count
+ *                     when updating cumulative table
+ */
+void decode_range(unsigned char* out, const unsigned char* in, size_t expected_size,
+                  size_t offset, size_t length, int precision, int update_range,
+                  int range_clear);
+
+/** @} */
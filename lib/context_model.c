@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "context_model.h"
+
+void init_context_model(context_model_t* model, int order, int context_bits, uint32_t increment, uint32_t limit)
+{
+  assert(((order == 1 && context_bits == 8) || (order == 2 && context_bits >= 8 && context_bits <= 16)) &&
+         "unsupported context parameters");
+
+  model->order        = order;
+  model->context_bits = context_bits;
+  model->increment    = increment;
+  model->limit        = limit;
+  model->allocated    = 0;
+  model->history      = 0;
+
+  model->pretrained_index = NULL;
+  model->pretrained       = NULL;
+
+  model->models = calloc((size_t) 1 << context_bits, sizeof(fenwick_model_t*));
+  assert(model->models && "memory allocation failed");
+}
+
+void reset_context_model(context_model_t* model)
+{
+  size_t i;
+
+  for (i = 0; i < ((size_t) 1 << model->context_bits); ++i) {
+    free(model->models[i]);
+    model->models[i] = NULL;
+  }
+  model->allocated = 0;
+  model->history   = 0;
+}
+
+void free_context_model(context_model_t* model)
+{
+  reset_context_model(model);
+  free(model->models);
+  model->models = NULL;
+}
+
+/** Frequency model of the current context of @p model (allocated on
+ *  first use) */
+static fenwick_model_t* current_model(context_model_t* model)
+{
+  uint32_t context;
+
+  if (model->order == 1) context = model->history & 0xff;
+  else if (model->context_bits == 16) context = model->history & 0xffff;
+  else context = ((model->history & 0xffff) * 0x9E3779B1u) >> (32 - model->context_bits);
+
+  fenwick_model_t* current = model->models[context];
+  if (!current) {
+    current = malloc(sizeof(fenwick_model_t));
+    assert(current && "memory allocation failed");
+    if (model->pretrained && model->pretrained_index[context]) {
+      *current = model->pretrained[model->pretrained_index[context] - 1];
+    } else {
+      init_fenwick_model(current, model->increment, model->limit);
+    }
+    model->models[context] = current;
+    model->allocated++;
+  }
+
+  return current;
+}
+
+void train_context_model(context_model_t* model, const unsigned char* in, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; ++i) {
+    fenwick_update(current_model(model), in[i]);
+    model->history = (model->history << 8) | in[i];
+  }
+}
+
+void encode_value_context(unsigned char* out, const unsigned char* in, size_t size, ac_state_t* state, context_model_t* model)
+{
+  size_t i;
+
+  assert(model->limit <= (1u << (state->frac_size - 1)) && "model limit exceeds coder precision");
+
+  for (i = 0; i < size; ++i) {
+    fenwick_encode_symbol(out, state, current_model(model), in[i]);
+    model->history = (model->history << 8) | in[i];
+  }
+
+  // code value selection (flushing buffer)
+  select_value(out, state);
+}
+
+void decode_value_context(unsigned char* out, unsigned char* in, ac_state_t* state, context_model_t* model, size_t expected_size)
+{
+  size_t i;
+
+  init_decoding(in, state);
+
+  for (i = 0; i < expected_size; ++i) {
+    out[i] = fenwick_decode_symbol(in, state, current_model(model));
+    model->history = (model->history << 8) | out[i];
+  }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arith_coding.h"
+#include "fenwick_model.h"
+
+/** \defgroup context_model context modeling
+ *  \brief Adaptive coding with a frequency model selected by the previous
+ *         one or two bytes (order-1 / order-2 context modeling)
+ *   @{
+ */
+
+/** Context-modeled adaptive coder: one fenwick_model_t per context,
+ *  allocated the first time the context is used (and initialized with the
+ *  pretrained model of the context if there is one) */
+typedef struct
+{
+  /** number of previous bytes used as context (1 or 2) */
+  int order;
+  /** log2 of the number of contexts (order-2 contexts are hashed) */
+  int context_bits;
+  /** context models (NULL until the context is first used) */
+  fenwick_model_t** models;
+  /** number of allocated context models */
+  size_t allocated;
+  /** frequency increment and limit of the context models */
+  uint32_t increment;
+  uint32_t limit;
+  /** previously coded bytes, most recent in the low byte */
+  uint32_t history;
+  /** pretrained context models (see model_file, NULL if none): context c
+   *  starts from pretrained[pretrained_index[c] - 1] if its index is not 0 */
+  const uint32_t* pretrained_index;
+  const fenwick_model_t* pretrained;
+} context_model_t;
+
+/** Initialize a context model with no allocated context
+ *  @param model context model to be initialized
+ *  @param order number of previous bytes used as context (1 or 2)
+ *  @param context_bits log2 of the number of contexts: must be 8 for
+ *                      order 1, between 8 and 16 for order 2 (the two
+ *                      previous bytes being hashed if it is lower than 16)
+ *  @param increment frequency increment of each context model
+ *  @param limit total frequency limit of each context model
+ *               (see init_fenwick_model)
+ */
+void init_context_model(context_model_t* model, int order, int context_bits,
+                        uint32_t increment, uint32_t limit);
+
+/** Update the context models of @p model with the bytes of @p in as if
+ *  they had been coded (training on a sample)
+ *  @param model context model
+ *  @param in sample byte-array
+ *  @param size number of bytes in @p in
+ */
+void train_context_model(context_model_t* model, const unsigned char* in, size_t size);
+
+/** Release the context models of @p model, which is reset to its
+ *  initial state (no allocated context, empty history) */
+void reset_context_model(context_model_t* model);
+
+/** Release all the memory allocated by @p model */
+void free_context_model(context_model_t* model);
+
+/** Arithmetic coding of a byte-array with context modeling
+ *  @param out byte-array used as output stream (at least encode_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state (see init_state)
+ *  @param model context model (see init_context_model)
+ */
+void encode_value_context(unsigned char* out, const unsigned char* in,
+                          size_t size, ac_state_t* state, context_model_t* model);
+
+/** Arithmetic decoding of a byte-array generated by encode_value_context,
+ *  @p model must be initialized as it was for encoding
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array containing the numerical code value
+ *  @param state arithmetic coder state (see init_state)
+ *  @param model context model (see init_context_model)
+ *  @param expected_size number of bytes to be decoded
+ */
+void decode_value_context(unsigned char* out, unsigned char* in,
+                          ac_state_t* state, context_model_t* model,
+                          size_t expected_size);
+
+/** @} */
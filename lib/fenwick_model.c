@@ -0,0 +1,138 @@
+#include <assert.h>
+
+#include "fenwick_model.h"
+
+/** lowest set bit of @p i */
+#define LOWBIT(i) ((i) & -(i))
+
+/** Build the tree of @p model from the symbol frequencies @p freq in O(n) */
+static void build_tree(fenwick_model_t* model, const uint32_t* freq)
+{
+  int i;
+
+  model->total = 0;
+  for (i = 1; i <= FENWICK_SYMBOLS; ++i) {
+    model->tree[i] = freq[i - 1];
+    model->total  += freq[i - 1];
+  }
+  for (i = 1; i <= FENWICK_SYMBOLS; ++i) {
+    int parent = i + LOWBIT(i);
+    if (parent <= FENWICK_SYMBOLS) model->tree[parent] += model->tree[i];
+  }
+}
+
+void init_fenwick_model(fenwick_model_t* model, uint32_t increment, uint32_t limit)
+{
+  uint32_t freq[FENWICK_SYMBOLS];
+  int i;
+
+  assert(increment > 0 && limit >= 2 * FENWICK_SYMBOLS + increment && limit + increment <= 0xffff &&
+         "invalid model parameters");
+
+  for (i = 0; i < FENWICK_SYMBOLS; ++i) freq[i] = 1;
+  build_tree(model, freq);
+
+  model->tree[0]   = 0;
+  model->increment = increment;
+  model->limit     = limit;
+}
+
+uint32_t fenwick_cumul(const fenwick_model_t* model, int symbol)
+{
+  uint32_t sum = 0;
+  int i;
+
+  for (i = symbol; i > 0; i -= LOWBIT(i)) sum += model->tree[i];
+
+  return sum;
+}
+
+uint32_t fenwick_frequency(const fenwick_model_t* model, int symbol)
+{
+  int i = symbol + 1;
+  int parent = i - LOWBIT(i);
+  uint32_t freq = model->tree[i];
+
+  // removing the sub-trees covered by entry i, except the symbol itself
+  for (i = i - 1; i > parent; i -= LOWBIT(i)) freq -= model->tree[i];
+
+  return freq;
+}
+
+/** Halve the frequencies of @p model (each one being kept strictly positive) */
+static void rescale(fenwick_model_t* model)
+{
+  uint32_t freq[FENWICK_SYMBOLS];
+  int i;
+
+  for (i = 0; i < FENWICK_SYMBOLS; ++i) freq[i] = (fenwick_frequency(model, i) + 1) / 2;
+  build_tree(model, freq);
+}
+
+void fenwick_update(fenwick_model_t* model, int symbol)
+{
+  int i;
+
+  for (i = symbol + 1; i <= FENWICK_SYMBOLS; i += LOWBIT(i)) model->tree[i] += model->increment;
+  model->total += model->increment;
+
+  if (model->total > model->limit) rescale(model);
+}
+
+int fenwick_find(const fenwick_model_t* model, uint32_t target, uint32_t* cum_low)
+{
+  uint32_t sum = 0;
+  int pos = 0, step;
+
+  // tree descent: pos is the largest prefix whose cumulative frequency
+  // does not exceed target
+  for (step = FENWICK_SYMBOLS; step > 0; step >>= 1) {
+    if (pos + step <= FENWICK_SYMBOLS && sum + model->tree[pos + step] <= target) {
+      pos += step;
+      sum += model->tree[pos];
+    }
+  }
+
+  *cum_low = sum;
+  return pos;
+}
+
+void fenwick_encode_symbol(unsigned char* out, ac_state_t* state, fenwick_model_t* model, unsigned char symbol)
+{
+  uint32_t cum_low = fenwick_cumul(model, symbol);
+
+  encode_interval(out, state, cum_low, cum_low + fenwick_frequency(model, symbol), model->total);
+  fenwick_update(model, symbol);
+}
+
+unsigned char fenwick_decode_symbol(unsigned char* in, ac_state_t* state, fenwick_model_t* model)
+{
+  uint32_t cum_low;
+  int symbol = fenwick_find(model, decode_target(state, model->total), &cum_low);
+
+  decode_interval(in, state, cum_low, cum_low + fenwick_frequency(model, symbol), model->total);
+  fenwick_update(model, symbol);
+
+  return symbol;
+}
+
+void encode_value_fenwick(unsigned char* out, const unsigned char* in, size_t size, ac_state_t* state, fenwick_model_t* model)
+{
+  size_t i;
+
+  assert(model->limit <= (1u << (state->frac_size - 1)) && "model limit exceeds coder precision");
+
+  for (i = 0; i < size; ++i) fenwick_encode_symbol(out, state, model, in[i]);
+
+  // code value selection (flushing buffer)
+  select_value(out, state);
+}
+
+void decode_value_fenwick(unsigned char* out, unsigned char* in, ac_state_t* state, fenwick_model_t* model, size_t expected_size)
+{
+  size_t i;
+
+  init_decoding(in, state);
+
+  for (i = 0; i < expected_size; ++i) out[i] = fenwick_decode_symbol(in, state, model);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arith_coding.h"
+
+/** \defgroup fenwick_model Fenwick tree adaptive model
+ *  \brief Adaptive byte model updated after each symbol, the cumulative
+ *         frequencies being maintained by a binary indexed (Fenwick) tree
+ *   @{
+ */
+
+/** number of symbols of the Fenwick model alphabet */
+#define FENWICK_SYMBOLS 256
+
+/** Adaptive frequency model, frequencies are stored on 16 bits to keep
+ *  the model compact (see context_model) */
+typedef struct
+{
+  /** binary indexed tree of the symbol frequencies: entry i (1 to
+   *  FENWICK_SYMBOLS) is the sum of the frequencies of the symbols
+   *  [i - lowbit(i), i) */
+  uint16_t tree[FENWICK_SYMBOLS + 1];
+  /** frequency increment applied to each coded symbol */
+  uint16_t increment;
+  /** frequencies are halved once total exceeds limit */
+  uint16_t limit;
+  /** sum of all the symbol frequencies */
+  uint32_t total;
+} fenwick_model_t;
+
+/** Initialize @p model with a frequency of 1 for each symbol
+ *  @param model frequency model to be initialized
+ *  @param increment frequency increment of each coded symbol (adaptation
+ *                   speed)
+ *  @param limit maximal total frequency before rescaling, it must not exceed
+ *               half the unit value of the coder state (1 << (precision - 1))
+ *               and limit + increment must fit in 16 bits
+ */
+void init_fenwick_model(fenwick_model_t* model, uint32_t increment, uint32_t limit);
+
+/** Cumulative frequency of the symbols preceding @p symbol in @p model */
+uint32_t fenwick_cumul(const fenwick_model_t* model, int symbol);
+
+/** Frequency of @p symbol in @p model */
+uint32_t fenwick_frequency(const fenwick_model_t* model, int symbol);
+
+/** Increment the frequency of @p symbol in @p model (halving all the
+ *  frequencies if the total exceeds the model limit) */
+void fenwick_update(fenwick_model_t* model, int symbol);
+
+/** Find the symbol whose cumulative interval contains @p target
+ *  @param model frequency model
+ *  @param target cumulative frequency (lower than model->total)
+ *  @param cum_low set to the cumulative frequency of the symbols preceding
+ *                 the returned symbol
+ *  @return symbol
+ */
+int fenwick_find(const fenwick_model_t* model, uint32_t target, uint32_t* cum_low);
+
+/** Arithmetic coding of @p symbol with @p model, the model is then updated
+ *  @param out byte array to be used as output stream
+ *  @param state arithmetic coder state
+ *  @param model adaptive frequency model
+ *  @param symbol byte to be coded
+ */
+void fenwick_encode_symbol(unsigned char* out, ac_state_t* state,
+                           fenwick_model_t* model, unsigned char symbol);
+
+/** Arithmetic decoding of a symbol with @p model, the model is then updated
+ *  @param in input buffer (numerical encoded value)
+ *  @param state arithmetic decoding state
+ *  @param model adaptive frequency model
+ *  @return decoded byte value
+ */
+unsigned char fenwick_decode_symbol(unsigned char* in, ac_state_t* state,
+                                    fenwick_model_t* model);
+
+/** Arithmetic coding of a byte-array with a model updated after each symbol
+ *  @param out byte-array used as output stream (at least encode_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state (see init_state)
+ *  @param model adaptive frequency model (see init_fenwick_model)
+ */
+void encode_value_fenwick(unsigned char* out, const unsigned char* in,
+                          size_t size, ac_state_t* state, fenwick_model_t* model);
+
+/** Arithmetic decoding of a byte-array generated by encode_value_fenwick,
+ *  @p model must be initialized as it was for encoding
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array containing the numerical code value
+ *  @param state arithmetic coder state (see init_state)
+ *  @param model adaptive frequency model (see init_fenwick_model)
+ *  @param expected_size number of bytes to be decoded
+ */
+void decode_value_fenwick(unsigned char* out, unsigned char* in,
+                          ac_state_t* state, fenwick_model_t* model,
+                          size_t expected_size);
+
+/** @} */
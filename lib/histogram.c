@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "histogram.h"
+
+/** number of interleaved count banks */
+#define HISTOGRAM_BANKS 4
+
+/** maximal number of bytes counted before the 32-bit banks are merged */
+#define HISTOGRAM_CHUNK ((size_t) 1 << 30)
+
+/** Add the byte counts of @p in to @p count (single thread) */
+static void histogram_chunk(size_t count[256], const unsigned char* in, size_t size)
+{
+  uint32_t bank[HISTOGRAM_BANKS][256];
+  size_t i = 0;
+  int b, s;
+
+  memset(bank, 0, sizeof(bank));
+
+  // two 64-bit words per iteration, the bytes being spread over the banks
+  for (; i + 16 <= size; i += 16) {
+    uint64_t w0, w1;
+    memcpy(&w0, in + i, 8);
+    memcpy(&w1, in + i + 8, 8);
+    for (b = 0; b < 8; b += 2) {
+      bank[0][(w0 >> (8 * b)) & 0xff]++;
+      bank[1][(w0 >> (8 * b + 8)) & 0xff]++;
+      bank[2][(w1 >> (8 * b)) & 0xff]++;
+      bank[3][(w1 >> (8 * b + 8)) & 0xff]++;
+    }
+  }
+  for (; i < size; ++i) bank[0][in[i]]++;
+
+  for (s = 0; s < 256; ++s) {
+    size_t sum = 0;
+    for (b = 0; b < HISTOGRAM_BANKS; ++b) sum += bank[b][s];
+    count[s] += sum;
+  }
+}
+
+/** Add the byte counts of @p in to @p count, by chunks small enough for
+ *  the 32-bit banks */
+static void histogram_range(size_t count[256], const unsigned char* in, size_t size)
+{
+  while (size > 0) {
+    size_t chunk = size < HISTOGRAM_CHUNK ? size : HISTOGRAM_CHUNK;
+    histogram_chunk(count, in, chunk);
+    in   += chunk;
+    size -= chunk;
+  }
+}
+
+/** Counting job of one thread */
+typedef struct
+{
+  size_t count[256];
+  const unsigned char* in;
+  size_t size;
+  /** the job runs in its own thread (to be joined) */
+  int started;
+} histogram_job_t;
+
+static void* histogram_worker(void* arg)
+{
+  histogram_job_t* job = arg;
+  histogram_range(job->count, job->in, job->size);
+  return NULL;
+}
+
+void ac_histogram(size_t count[256], const unsigned char* in, size_t size, int threads)
+{
+  int i, s;
+
+  memset(count, 0, sizeof(size_t) * 256);
+
+  if (threads <= 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if ((size_t) threads > size / AC_HISTOGRAM_THREAD_MIN) threads = (int) (size / AC_HISTOGRAM_THREAD_MIN);
+
+  if (threads <= 1) {
+    histogram_range(count, in, size);
+    return;
+  }
+
+  pthread_t* workers   = malloc(sizeof(pthread_t) * threads);
+  histogram_job_t* jobs = calloc(threads, sizeof(histogram_job_t));
+  assert(workers && jobs && "memory allocation failed");
+
+  // the calling thread counts the first part
+  size_t part = size / threads;
+  for (i = 0; i < threads; ++i) {
+    jobs[i].in   = in + i * part;
+    jobs[i].size = i == threads - 1 ? size - i * part : part;
+  }
+  for (i = 1; i < threads; ++i) jobs[i].started = !pthread_create(workers + i, NULL, histogram_worker, jobs + i);
+  histogram_worker(jobs);
+  // parts whose thread could not be created are counted here
+  for (i = 1; i < threads; ++i) {
+    if (jobs[i].started) pthread_join(workers[i], NULL);
+    else histogram_worker(jobs + i);
+  }
+
+  for (i = 0; i < threads; ++i) {
+    for (s = 0; s < 256; ++s) count[s] += jobs[i].count[s];
+  }
+
+  free(workers);
+  free(jobs);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+
+/** \defgroup histogram histogram
+ *  \brief Byte occurence counting
+ *   @{
+ */
+
+/** minimal number of bytes counted by each thread of ac_histogram */
+#define AC_HISTOGRAM_THREAD_MIN (1 << 20)
+
+/** Count the occurences of each byte value in @p in. Counts are
+ *  accumulated in interleaved count banks (merged at the end) so that
+ *  consecutive identical bytes do not serialize on the same counter.
+ *  @param count output table, count[b] is set to the number of bytes
+ *               of value b in @p in
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param threads maximal number of counting threads (0 for one per online
+ *                 CPU), each thread counting at least AC_HISTOGRAM_THREAD_MIN
+ *                 bytes
+ */
+void ac_histogram(size_t count[256], const unsigned char* in, size_t size, int threads);
+
+/** @} */
@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "fenwick_model.h"
+#include "lz_coding.h"
+
+/** log2 of the number of hash chains (hash of the next LZ_MIN_MATCH bytes) */
+#define LZ_HASH_BITS 16
+
+/** frequency increment and limit of the adaptive models */
+#define LZ_INCREMENT 32
+#define LZ_LIMIT (1 << 15)
+
+/** Adaptive models of the LZ77 symbols: a command (0 for a literal, the
+ *  match length - LZ_MIN_MATCH + 1 otherwise), the literal byte and the
+ *  distance slot (number of significant bits of distance - 1), the bits
+ *  below the leading one being coded uniformly */
+typedef struct
+{
+  fenwick_model_t command;
+  fenwick_model_t literal;
+  fenwick_model_t slot;
+} lz_models_t;
+
+static void init_lz_models(lz_models_t* models, const ac_state_t* state)
+{
+  assert(LZ_LIMIT <= (1u << (state->frac_size - 1)) && "model limit exceeds coder precision");
+
+  init_fenwick_model(&models->command, LZ_INCREMENT, LZ_LIMIT);
+  init_fenwick_model(&models->literal, LZ_INCREMENT, LZ_LIMIT);
+  init_fenwick_model(&models->slot, LZ_INCREMENT, LZ_LIMIT);
+}
+
+/** Hash chain of the LZ_MIN_MATCH bytes at @p in */
+static inline uint32_t lz_hash(const unsigned char* in)
+{
+  uint32_t value = in[0] | (in[1] << 8) | (in[2] << 16);
+  return (value * 0x9E3779B1u) >> (32 - LZ_HASH_BITS);
+}
+
+/** Number of significant bits of @p value (0 for 0) */
+static inline int bit_length(uint32_t value)
+{
+  int bits = 0;
+  while (value >> bits) bits++;
+  return bits;
+}
+
+size_t lz_bound(size_t size, int precision)
+{
+  // a literal is coded with two symbols, a match (at least LZ_MIN_MATCH
+  // bytes) with at most 2 + (LZ_MAX_WINDOW_BITS + 7) / 8 symbols
+  return encode_bound(2 * size, precision);
+}
+
+/** Code the @p count low bits of @p value uniformly, by chunks of 8 bits */
+static void encode_raw_bits(unsigned char* out, ac_state_t* state, uint32_t value, int count)
+{
+  while (count > 0) {
+    int bits = count < 8 ? count : 8;
+    uint32_t chunk = (value >> (count - bits)) & ((1u << bits) - 1);
+    encode_interval(out, state, chunk, chunk + 1, 1u << bits);
+    count -= bits;
+  }
+}
+
+/** Decode @p count bits coded by encode_raw_bits */
+static uint32_t decode_raw_bits(unsigned char* in, ac_state_t* state, int count)
+{
+  uint32_t value = 0;
+
+  while (count > 0) {
+    int bits = count < 8 ? count : 8;
+    uint32_t chunk = decode_target(state, 1u << bits);
+    decode_interval(in, state, chunk, chunk + 1, 1u << bits);
+    value = (value << bits) | chunk;
+    count -= bits;
+  }
+
+  return value;
+}
+
+void encode_value_lz(unsigned char* out, const unsigned char* in, size_t size,
+                     ac_state_t* state, int window_bits, int max_chain)
+{
+  assert(window_bits >= LZ_MIN_WINDOW_BITS && window_bits <= LZ_MAX_WINDOW_BITS && max_chain >= 1 &&
+         "invalid LZ parameters");
+  assert(size < 0xffffffffu && "input too large");
+
+  const uint32_t window_mask = (1u << window_bits) - 1;
+  lz_models_t models;
+  init_lz_models(&models, state);
+
+  // chain heads and links store position + 1 (0 ending a chain), the link
+  // of position p being overwritten once p leaves the window
+  uint32_t* head = calloc((size_t) 1 << LZ_HASH_BITS, sizeof(uint32_t));
+  uint32_t* prev = malloc(sizeof(uint32_t) << window_bits);
+  assert(head && prev && "memory allocation failed");
+
+  size_t pos = 0;
+  while (pos < size) {
+    size_t best_length = 0, best_distance = 0;
+    size_t max_length = size - pos < LZ_MAX_MATCH ? size - pos : LZ_MAX_MATCH;
+
+    if (max_length >= LZ_MIN_MATCH) {
+      uint32_t candidate = head[lz_hash(in + pos)];
+      int chain = max_chain;
+
+      while (candidate && chain--) {
+        size_t match = candidate - 1;
+        if (pos - match > window_mask) break;
+
+        // the byte after the current best is compared first
+        if (in[match + best_length] == in[pos + best_length]) {
+          size_t length = 0;
+          while (length < max_length && in[match + length] == in[pos + length]) length++;
+          if (length > best_length) {
+            best_length   = length;
+            best_distance = pos - match;
+            if (length == max_length) break;
+          }
+        }
+        candidate = prev[match & window_mask];
+      }
+    }
+
+    size_t coded = 1;
+    if (best_length >= LZ_MIN_MATCH) {
+      uint32_t distance = best_distance - 1;
+      int slot = bit_length(distance);
+
+      fenwick_encode_symbol(out, state, &models.command, best_length - LZ_MIN_MATCH + 1);
+      fenwick_encode_symbol(out, state, &models.slot, slot);
+      if (slot > 1) encode_raw_bits(out, state, distance, slot - 1);
+      coded = best_length;
+    } else {
+      fenwick_encode_symbol(out, state, &models.command, 0);
+      fenwick_encode_symbol(out, state, &models.literal, in[pos]);
+    }
+
+    // inserting the coded positions in their hash chain
+    for (; coded > 0; --coded, ++pos) {
+      if (size - pos < LZ_MIN_MATCH) continue;
+      uint32_t hash = lz_hash(in + pos);
+      prev[pos & window_mask] = head[hash];
+      head[hash] = pos + 1;
+    }
+  }
+
+  // code value selection (flushing buffer)
+  select_value(out, state);
+
+  free(head);
+  free(prev);
+}
+
+void decode_value_lz(unsigned char* out, unsigned char* in, ac_state_t* state,
+                     size_t expected_size)
+{
+  lz_models_t models;
+  init_lz_models(&models, state);
+
+  init_decoding(in, state);
+
+  size_t pos = 0;
+  while (pos < expected_size) {
+    int command = fenwick_decode_symbol(in, state, &models.command);
+
+    if (!command) {
+      out[pos++] = fenwick_decode_symbol(in, state, &models.literal);
+      continue;
+    }
+
+    size_t length = command + LZ_MIN_MATCH - 1;
+    int slot = fenwick_decode_symbol(in, state, &models.slot);
+    assert(slot <= LZ_MAX_WINDOW_BITS && "invalid distance");
+    size_t distance = (slot > 1 ? ((1u << (slot - 1)) | decode_raw_bits(in, state, slot - 1)) : slot) + 1;
+    assert(distance <= pos && length <= expected_size - pos && "invalid match");
+
+    // byte copy, the match may overlap the bytes it produces
+    const unsigned char* match = out + pos - distance;
+    size_t i;
+    for (i = 0; i < length; ++i) out[pos + i] = match[i];
+    pos += length;
+  }
+}
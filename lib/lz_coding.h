@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arith_coding.h"
+
+/** \defgroup lz_coding LZ77 coding
+ *  \brief Hash-chain LZ77 match finder in front of the arithmetic coder:
+ *         literals, match lengths and distances are coded with their own
+ *         adaptive frequency model (see fenwick_model)
+ *   @{
+ */
+
+/** shortest coded match */
+#define LZ_MIN_MATCH 3
+/** longest coded match (longer repetitions are coded as several matches) */
+#define LZ_MAX_MATCH (LZ_MIN_MATCH + 254)
+/** window size bounds (log2 of the largest match distance + 1) */
+#define LZ_MIN_WINDOW_BITS 8
+#define LZ_MAX_WINDOW_BITS 24
+
+/** Size of an output buffer large enough for the LZ77 coding of @p size
+ *  bytes with a coder state of precision @p precision */
+size_t lz_bound(size_t size, int precision);
+
+/** LZ77 compression of a byte-array: each position is either coded as a
+ *  literal or as a match (length, distance) against the previous
+ *  2^window_bits bytes, found through hash chains
+ *  @param out byte-array used as output stream (at least lz_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state (see init_state, precision 16 or more)
+ *  @param window_bits log2 of the window size (LZ_MIN_WINDOW_BITS to
+ *                     LZ_MAX_WINDOW_BITS), the match finder allocating
+ *                     4 << window_bits bytes
+ *  @param max_chain effort level: maximal number of previous positions
+ *                   compared to find a match (1 for the fastest coding)
+ */
+void encode_value_lz(unsigned char* out, const unsigned char* in, size_t size,
+                     ac_state_t* state, int window_bits, int max_chain);
+
+/** Decoding of a byte-array generated by encode_value_lz (the window size
+ *  and effort level are not needed)
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array containing the numerical code value
+ *  @param state arithmetic coder state (same precision as for encoding)
+ *  @param expected_size number of bytes to be decoded
+ */
+void decode_value_lz(unsigned char* out, unsigned char* in, ac_state_t* state,
+                     size_t expected_size);
+
+/** @} */
@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "arith_coding.h"
+#include "context_model.h"
+#include "model_file.h"
+
+/** Model file layout: a header followed by the tables, in the byte order
+ *  of the machine which wrote the file so that they can be used in place.
+ *
+ *  header (MODEL_HEADER_SIZE bytes, 32-bit fields):
+ *    magic "ACM" + format version, byte order mark (0x01020304),
+ *    precision, decode_bits, order, context_bits, increment, limit,
+ *    sizeof(fenwick_model_t), number of pretrained contexts
+ *  order-0 tables: prob_table (256 ints), cumul_table (257 ints) and
+ *  decode_table ((1 << decode_bits) + 1 entries)
+ *  context models (order > 0): context index (1 << context_bits entries,
+ *  see ac_model_t) followed by the pretrained fenwick_model_t
+ *  Each section starts on a MODEL_ALIGN byte boundary.
+ */
+#define MODEL_HEADER_SIZE 64
+#define MODEL_ALIGN 64
+#define MODEL_BYTE_ORDER 0x01020304u
+
+/** Section offsets of a model file */
+typedef struct
+{
+  size_t prob_table;
+  size_t cumul_table;
+  size_t decode_table;
+  size_t context_index;
+  size_t contexts;
+  size_t size;
+} model_layout_t;
+
+static size_t align_offset(size_t offset)
+{
+  return (offset + MODEL_ALIGN - 1) / MODEL_ALIGN * MODEL_ALIGN;
+}
+
+static model_layout_t model_layout(int decode_bits, int order, int context_bits, size_t context_count)
+{
+  model_layout_t layout;
+
+  layout.prob_table    = MODEL_HEADER_SIZE;
+  layout.cumul_table   = align_offset(layout.prob_table + sizeof(int) * 256);
+  layout.decode_table  = align_offset(layout.cumul_table + sizeof(int) * 257);
+  layout.context_index = align_offset(layout.decode_table + sizeof(uint16_t) * ((1 << decode_bits) + 1));
+  layout.contexts      = align_offset(layout.context_index + (order ? sizeof(uint32_t) << context_bits : 0));
+  layout.size          = layout.contexts + sizeof(fenwick_model_t) * context_count;
+
+  return layout;
+}
+
+int ac_write_model(const char* filename, const unsigned char* sample, size_t size,
+                   int precision, int order, int context_bits, uint32_t increment,
+                   uint32_t limit)
+{
+  ac_storage_t storage;
+  ac_state_t state;
+  context_model_t context;
+  size_t context_count = 0;
+  size_t c;
+
+  if (!order) context_bits = 0;
+
+  // order-0 tables
+  init_state_with_storage(&state, precision, &storage);
+  assert(size <= 0x7fffffff && "sample too large");
+  build_probability_table(&state, sample, (int) size);
+  enable_decode_lookup(&state);
+
+  if (order) {
+    init_context_model(&context, order, context_bits, increment, limit);
+    train_context_model(&context, sample, size);
+    context_count = context.allocated;
+  }
+
+  model_layout_t layout = model_layout(state.decode_bits, order, context_bits, context_count);
+  unsigned char* image = calloc(1, layout.size);
+  assert(image && "memory allocation failed");
+
+  uint32_t header[10] = {0, MODEL_BYTE_ORDER, precision, state.decode_bits, order, context_bits,
+                         increment, limit, sizeof(fenwick_model_t), context_count};
+  memcpy(header, "ACM", 3);
+  ((unsigned char*) header)[3] = AC_MODEL_VERSION;
+  memcpy(image, header, sizeof(header));
+
+  memcpy(image + layout.prob_table, storage.prob_table, sizeof(int) * 256);
+  memcpy(image + layout.cumul_table, storage.cumul_table, sizeof(int) * 257);
+  memcpy(image + layout.decode_table, storage.decode_table, sizeof(uint16_t) * ((1 << state.decode_bits) + 1));
+
+  if (order) {
+    uint32_t* context_index = (uint32_t*) (image + layout.context_index);
+    fenwick_model_t* contexts = (fenwick_model_t*) (image + layout.contexts);
+    size_t stored = 0;
+
+    for (c = 0; c < ((size_t) 1 << context_bits); ++c) {
+      if (!context.models[c]) continue;
+      contexts[stored++] = *context.models[c];
+      context_index[c] = stored;
+    }
+    free_context_model(&context);
+  }
+
+  FILE* output = fopen(filename, "wb");
+  int success = output && fwrite(image, 1, layout.size, output) == layout.size;
+  if (output && fclose(output)) success = 0;
+
+  free(image);
+
+  return success;
+}
+
+/** Check the mapped order-0 tables of @p model: cumulative frequencies
+ *  starting from 0, non-decreasing and within the precision, the lookup
+ *  table being the one built from them */
+static int valid_tables(const ac_model_t* model)
+{
+  ac_storage_t storage;
+  ac_state_t state;
+  int i;
+
+  if (model->cumul_table[0] != 0 || model->cumul_table[256] > (1 << model->precision)) return 0;
+  for (i = 0; i < 256; ++i) {
+    if (model->cumul_table[i + 1] < model->cumul_table[i]) return 0;
+  }
+
+  init_state_with_storage(&state, model->precision, &storage);
+  memcpy(storage.cumul_table, model->cumul_table, sizeof(storage.cumul_table));
+  enable_decode_lookup(&state);
+
+  return state.decode_bits == model->decode_bits &&
+         !memcmp(storage.decode_table, model->decode_table, sizeof(uint16_t) * ((1 << model->decode_bits) + 1));
+}
+
+/** Check a pretrained context model: parameters of the model file and
+ *  strictly positive frequencies summing to its total (so that the tree
+ *  descent of fenwick_find always ends on a symbol) */
+static int valid_context(const fenwick_model_t* context, const ac_model_t* model)
+{
+  uint32_t tree[FENWICK_SYMBOLS + 1];
+  uint32_t total = 0;
+  int i;
+
+  if (context->increment != model->increment || context->limit != model->limit ||
+      context->total > model->limit + model->increment) {
+    return 0;
+  }
+
+  // frequencies recovered from the tree (reverse of its construction)
+  for (i = 1; i <= FENWICK_SYMBOLS; ++i) tree[i] = context->tree[i];
+  for (i = FENWICK_SYMBOLS; i > 0; --i) {
+    int parent = i + (i & -i);
+    if (parent <= FENWICK_SYMBOLS) {
+      if (tree[parent] < tree[i]) return 0;
+      tree[parent] -= tree[i];
+    }
+  }
+  for (i = 1; i <= FENWICK_SYMBOLS; ++i) {
+    if (!tree[i]) return 0;
+    total += tree[i];
+  }
+
+  return total == context->total;
+}
+
+int ac_load_model(ac_model_t* model, const char* filename)
+{
+  struct stat st;
+  int fd = open(filename, O_RDONLY);
+
+  if (fd < 0) return 0;
+  if (fstat(fd, &st) || st.st_size < MODEL_HEADER_SIZE) {
+    close(fd);
+    return 0;
+  }
+
+  // read-only mapping: the tables are shared by all the states using them
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return 0;
+
+  model->map      = map;
+  model->map_size = st.st_size;
+
+  uint32_t header[10];
+  memcpy(header, map, sizeof(header));
+
+  model->precision     = header[2];
+  model->decode_bits   = header[3];
+  model->order         = header[4];
+  model->context_bits  = header[5];
+  model->increment     = header[6];
+  model->limit         = header[7];
+  model->context_count = header[9];
+
+  int valid = !memcmp(map, "ACM", 3) && ((unsigned char*) map)[3] == AC_MODEL_VERSION &&
+              header[1] == MODEL_BYTE_ORDER && header[8] == sizeof(fenwick_model_t) &&
+              model->precision >= 12 && model->precision <= 24 &&
+              model->decode_bits == (model->precision < AC_LOOKUP_BITS ? model->precision : AC_LOOKUP_BITS) &&
+              ((model->order == 0 && model->context_bits == 0) || (model->order == 1 && model->context_bits == 8) ||
+               (model->order == 2 && model->context_bits >= 8 && model->context_bits <= 16)) &&
+              model->context_count <= ((size_t) 1 << model->context_bits) &&
+              (model->order == 0 || (model->increment > 0 && model->limit >= 2 * FENWICK_SYMBOLS + model->increment &&
+                                     model->limit + model->increment <= 0xffff &&
+                                     model->limit <= (1u << (model->precision - 1))));
+
+  // the layout is only computed from validated fields
+  model_layout_t layout;
+  if (!valid || (layout = model_layout(model->decode_bits, model->order, model->context_bits,
+                                       model->context_count)).size != model->map_size) {
+    ac_unload_model(model);
+    return 0;
+  }
+
+  model->prob_table    = (const int*) (model->map + layout.prob_table);
+  model->cumul_table   = (const int*) (model->map + layout.cumul_table);
+  model->decode_table  = (const uint16_t*) (model->map + layout.decode_table);
+  model->context_index = model->order ? (const uint32_t*) (model->map + layout.context_index) : NULL;
+  model->contexts      = model->order ? (const fenwick_model_t*) (model->map + layout.contexts) : NULL;
+
+  // context indices are 1-based (0 for an untrained context)
+  size_t c;
+  valid = valid_tables(model);
+  for (c = 0; valid && model->order && c < ((size_t) 1 << model->context_bits); ++c) {
+    valid = model->context_index[c] <= model->context_count;
+  }
+  for (c = 0; valid && c < model->context_count; ++c) valid = valid_context(model->contexts + c, model);
+  if (!valid) {
+    ac_unload_model(model);
+    return 0;
+  }
+
+  return 1;
+}
+
+void ac_unload_model(ac_model_t* model)
+{
+  if (model->map) munmap((void*) model->map, model->map_size);
+  model->map = NULL;
+  model->map_size = 0;
+}
+
+void init_state_with_model(ac_state_t* state, const ac_model_t* model)
+{
+  // the tables are only read: the state refuses to update them
+  init_state_with_tables(state, model->precision, (int*) model->prob_table, (int*) model->cumul_table, NULL);
+  state->read_only = 1;
+
+  // the lookup table is already built
+  state->decode_table   = (uint16_t*) model->decode_table;
+  state->decode_storage = state->decode_table;
+  state->decode_bits    = model->decode_bits;
+}
+
+void init_context_model_with_model(context_model_t* context, const ac_model_t* model)
+{
+  assert(model->order && "model has no context model");
+
+  init_context_model(context, model->order, model->context_bits, model->increment, model->limit);
+  context->pretrained_index = model->context_index;
+  context->pretrained       = model->contexts;
+}
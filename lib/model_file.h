@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arith_coding.h"
+#include "fenwick_model.h"
+#include "context_model.h"
+
+/** \defgroup model_file model files
+ *  \brief Pretrained models stored in files and loaded through mmap
+ *   @{
+ */
+
+/** model file format version */
+#define AC_MODEL_VERSION 1
+
+/** Pretrained model loaded from a model file. The tables are used in place
+ *  in a read-only file mapping shared by all the processes loading the same
+ *  file (the static coders only read the order-0 tables and context models
+ *  are copied on first use). */
+typedef struct
+{
+  /** file mapping */
+  const unsigned char* map;
+  size_t map_size;
+  /** fixed-point precision of the order-0 tables */
+  int precision;
+  /** order-0 probability, cumulative and lookup tables (see ac_state_t) */
+  const int* prob_table;
+  const int* cumul_table;
+  const uint16_t* decode_table;
+  int decode_bits;
+  /** context model parameters (order 0 if the file has no context model) */
+  int order;
+  int context_bits;
+  uint32_t increment;
+  uint32_t limit;
+  /** number of pretrained contexts, context c being trained if
+   *  context_index[c] is not 0 (contexts[context_index[c] - 1]) */
+  size_t context_count;
+  const uint32_t* context_index;
+  const fenwick_model_t* contexts;
+} ac_model_t;
+
+/** Train a model on @p sample and write it to @p filename: order-0 tables
+ *  (see build_probability_table) and, if @p order is not 0, the context
+ *  models of a context_model_t trained on the sample
+ *  @param filename model file
+ *  @param sample training corpus
+ *  @param size number of bytes in @p sample
+ *  @param precision fixed-point precision of the coder states
+ *  @param order context order (0 for order-0 tables only, 1 or 2)
+ *  @param context_bits log2 of the number of contexts (see
+ *                      init_context_model)
+ *  @param increment frequency increment of the context models
+ *  @param limit total frequency limit of the context models
+ *  @return 1 on success, 0 if the file can not be written
+ */
+int ac_write_model(const char* filename, const unsigned char* sample, size_t size,
+                   int precision, int order, int context_bits, uint32_t increment,
+                   uint32_t limit);
+
+/** Map the model file @p filename (no copy, no training)
+ *  @param model loaded model
+ *  @param filename model file written by ac_write_model (on a machine
+ *                  with the same byte order)
+ *  @return 1 on success, 0 if the file can not be mapped or is not a
+ *          valid model file
+ */
+int ac_load_model(ac_model_t* model, const char* filename);
+
+/** Unmap @p model, the states and context models using it must no longer
+ *  be used */
+void ac_unload_model(ac_model_t* model);
+
+/** Initialize @p state with the order-0 tables of @p model, ready for
+ *  static coding (encode_value / decode_value) with the lookup table
+ *  enabled. No table is allocated (see ac_free_state) and the tables are
+ *  read-only: table updates (adaptive coding, ac_reset, table rebuilds)
+ *  are refused by an assertion.
+ *  @param state arithmetic coder state
+ *  @param model loaded model
+ */
+void init_state_with_model(ac_state_t* state, const ac_model_t* model);
+
+/** Initialize @p context with the pretrained context models of @p model
+ *  (which must have some), see init_context_model
+ *  @param context context model to be initialized
+ *  @param model loaded model
+ */
+void init_context_model_with_model(context_model_t* context, const ac_model_t* model);
+
+/** @} */
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "rans_coding.h"
+
+/** lower bound of the normalized rANS state interval [RANS_L, RANS_L << 8) */
+#define RANS_L (1u << 23)
+
+/** Cumulative frequency of symbol @p s in @p state, the frequencies of
+ *  the probability table summing to 1.0 (the last symbol absorbing the
+ *  unit missing from cumul_table[256]) */
+static uint32_t rans_cumul(ac_state_t* state, int s)
+{
+  return s == 256 ? (uint32_t) 1 << state->frac_size : (uint32_t) state->cumul_table[s];
+}
+
+/** Find the symbol whose cumulative interval contains @p slot */
+static int rans_find_symbol(ac_state_t* state, uint32_t slot)
+{
+  int s = 0, n = 256;
+
+  if (state->decode_table) {
+    s = state->decode_table[slot >> (state->frac_size - state->decode_bits)];
+    while (s < 255 && rans_cumul(state, s + 1) <= slot) s++;
+    return s;
+  }
+
+  while (n - s > 1) {
+    int m = (s + n) / 2;
+    if (rans_cumul(state, m) > slot) n = m;
+    else s = m;
+  }
+  return s;
+}
+
+size_t rans_bound(size_t size, int precision)
+{
+  // at most precision bits per symbol, plus the final 4-byte state
+  // and the initial state digits
+  return (size * precision + 7) / 8 + 8;
+}
+
+size_t rans_encode_value(unsigned char* out, const unsigned char* in,
+                         size_t size, ac_state_t* state)
+{
+  assert(state->frac_size <= 23 && "rANS precision must not exceed 23 bits");
+  assert(state->alphabet_size == 256 && "rANS coding requires a 256 symbol alphabet");
+
+  size_t bound = rans_bound(size, state->frac_size);
+  unsigned char* ptr = out + bound;
+  uint32_t x = RANS_L;
+  size_t i;
+
+  // symbols are coded in reverse order, the output being written backwards
+  for (i = size; i > 0; --i) {
+    int s = in[i - 1];
+    uint32_t start = rans_cumul(state, s);
+    uint32_t freq  = rans_cumul(state, s + 1) - start;
+    assert(freq > 0 && "symbol with null probability");
+
+    // renormalization
+    uint32_t x_max = ((RANS_L >> state->frac_size) << 8) * freq;
+    while (x >= x_max) {
+      *--ptr = (unsigned char) x;
+      x >>= 8;
+    }
+
+    x = ((x / freq) << state->frac_size) + (x % freq) + start;
+  }
+
+  // final state
+  ptr -= 4;
+  ptr[0] = (unsigned char) (x >> 24);
+  ptr[1] = (unsigned char) (x >> 16);
+  ptr[2] = (unsigned char) (x >> 8);
+  ptr[3] = (unsigned char) x;
+
+  size_t encoded_size = out + bound - ptr;
+  memmove(out, ptr, encoded_size);
+
+  return encoded_size;
+}
+
+void rans_decode_value(unsigned char* out, const unsigned char* in,
+                       ac_state_t* state, size_t expected_size)
+{
+  assert(state->alphabet_size == 256 && "rANS coding requires a 256 symbol alphabet");
+
+  uint32_t mask = ((uint32_t) 1 << state->frac_size) - 1;
+  uint32_t x = ((uint32_t) in[0] << 24) | ((uint32_t) in[1] << 16) | ((uint32_t) in[2] << 8) | in[3];
+  size_t i;
+
+  in += 4;
+  for (i = 0; i < expected_size; ++i) {
+    uint32_t slot = x & mask;
+    int s = rans_find_symbol(state, slot);
+    uint32_t start = rans_cumul(state, s);
+
+    out[i] = s;
+    x = (rans_cumul(state, s + 1) - start) * (x >> state->frac_size) + slot - start;
+
+    // renormalization
+    while (x < RANS_L) x = (x << 8) | *in++;
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "arith_coding.h"
+
+/** \defgroup rans_coding range ANS coding
+ *  \brief Range asymmetric numeral system (rANS) encoding and decoding
+ *         functions using the static probability model of ac_state_t
+ *   @{
+ */
+
+/** Upper bound on the number of bytes written by rans_encode_value
+ *  @param size number of input bytes
+ *  @param precision fixed-point precision of the probability table
+ *  @return maximal encoded size (in bytes)
+ */
+size_t rans_bound(size_t size, int precision);
+
+/** rANS coding of a byte-array with the cumulative probability table of
+ *  @p state (as built by build_probability_table or
+ *  reset_uniform_probability), the state precision must not exceed 23.
+ *  The 32-bit coder state is renormalized by bytes.
+ *  @param out byte-array used as output stream (at least rans_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state arithmetic coder state (parameters + probability table of
+ *               a 256 symbol alphabet)
+ *  @return number of bytes written to @p out
+ */
+size_t rans_encode_value(unsigned char* out, const unsigned char* in,
+                         size_t size, ac_state_t* state);
+
+/** rANS decoding of @p expected_size bytes from @p in, @p state must contain
+ *  the probability table used for encoding (the symbol lookup table of
+ *  @p state is used if it is enabled, see enable_decode_lookup)
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array (generated by rans_encode_value)
+ *  @param state arithmetic coder state (parameters + probability table of
+ *               a 256 symbol alphabet)
+ *  @param expected_size number of bytes to be decoded
+ */
+void rans_decode_value(unsigned char* out, const unsigned char* in,
+                       ac_state_t* state, size_t expected_size);
+
+/** @} */
@@ -0,0 +1,150 @@
+#include <assert.h>
+
+#include "wide_coding.h"
+#include "histogram.h"
+
+/** the range is renormalized (by bytes) once it falls below RANGE_BOTTOM */
+#define RANGE_BOTTOM ((uint64_t) 1 << 48)
+/** width of the low register (without the carry bit) */
+#define LOW_BITS 56
+
+/** Rebuild the symbol lookup table of @p state from its cumulative table */
+static void build_wide_lookup(wide_state_t* state)
+{
+  int shift = state->frac_size - WIDE_LOOKUP_BITS;
+  int i, s = 0;
+
+  for (i = 0; i < (1 << WIDE_LOOKUP_BITS); ++i) {
+    while (state->cumul_table[s + 1] <= ((uint64_t) i << shift)) s++;
+    state->decode_table[i] = s;
+  }
+}
+
+void init_wide_state(wide_state_t* state, int precision)
+{
+  int s;
+
+  assert(precision >= WIDE_MIN_PRECISION && precision <= WIDE_MAX_PRECISION && "unsupported precision");
+  state->frac_size = precision;
+
+  for (s = 0; s <= 256; ++s) state->cumul_table[s] = ((uint64_t) s << precision) / 256;
+  build_wide_lookup(state);
+
+  state->low        = 0;
+  state->range      = 0;
+  state->code       = 0;
+  state->cache      = 0;
+  state->cache_size = 1;
+  state->byte_index = 0;
+}
+
+void wide_build_probability_table(wide_state_t* state, const unsigned char* in, size_t size)
+{
+  uint64_t total = (uint64_t) 1 << state->frac_size;
+  size_t count[256];
+  uint64_t sum = 0;
+  int s, shift = 0;
+
+  ac_histogram(count, in, size, 1);
+
+  // counts (+1 for each symbol) are scaled down until their product with
+  // the table total fits in 64 bits
+  for (s = 0; s < 256; ++s) sum += count[s] + 1;
+  while ((sum >> shift) + 256 >= ((uint64_t) 1 << (64 - WIDE_MAX_PRECISION))) shift++;
+  for (sum = 0, s = 0; s < 256; ++s) sum += (count[s] >> shift) + 1;
+
+  // each symbol keeps at least one unit, the last one absorbs the rounding
+  state->cumul_table[0] = 0;
+  for (s = 0; s < 256; ++s) {
+    uint64_t freq = 1 + ((count[s] >> shift) + 1) * (total - 256) / sum;
+    state->cumul_table[s + 1] = state->cumul_table[s] + freq;
+  }
+  assert(state->cumul_table[256] <= total && "invalid cumulative table");
+  state->cumul_table[256] = total;
+
+  build_wide_lookup(state);
+}
+
+size_t wide_bound(size_t size, int precision)
+{
+  // at most precision bits per symbol (plus the range truncation loss, below
+  // 2^-16 per symbol), plus the 8 flushed bytes
+  return (size * precision + 7) / 8 + size / 4096 + 8;
+}
+
+/** Shift the top byte of the low register out of @p state, bytes being
+ *  held back as long as a carry may still reach them */
+static void shift_low(unsigned char* out, wide_state_t* state)
+{
+  uint64_t top = state->low >> (LOW_BITS - 8);
+
+  if (top != 0xff) {
+    unsigned char carry = (unsigned char) (top >> 8);
+    unsigned char byte  = state->cache;
+    do {
+      out[state->byte_index++] = byte + carry;
+      byte = 0xff;
+    } while (--state->cache_size != 0);
+    state->cache = (unsigned char) top;
+  }
+  state->cache_size++;
+  state->low = (state->low & (((uint64_t) 1 << (LOW_BITS - 8)) - 1)) << 8;
+}
+
+size_t encode_value_wide(unsigned char* out, const unsigned char* in, size_t size, wide_state_t* state)
+{
+  size_t i;
+  int k;
+
+  state->low        = 0;
+  state->range      = ((uint64_t) 1 << LOW_BITS) - 1;
+  state->cache      = 0;
+  state->cache_size = 1;
+  state->byte_index = 0;
+
+  for (i = 0; i < size; ++i) {
+    uint64_t r = state->range >> state->frac_size;
+    state->low  += r * state->cumul_table[in[i]];
+    state->range = r * (state->cumul_table[in[i] + 1] - state->cumul_table[in[i]]);
+
+    while (state->range < RANGE_BOTTOM) {
+      state->range <<= 8;
+      shift_low(out, state);
+    }
+  }
+
+  // flushing the low register and the cached bytes
+  for (k = 0; k < LOW_BITS / 8 + 1; ++k) shift_low(out, state);
+
+  return state->byte_index;
+}
+
+void decode_value_wide(unsigned char* out, const unsigned char* in, wide_state_t* state, size_t expected_size)
+{
+  size_t i;
+  int k;
+
+  state->range      = ((uint64_t) 1 << LOW_BITS) - 1;
+  state->code       = 0;
+  state->byte_index = 1; // first byte (initial cache) is always 0
+  for (k = 0; k < LOW_BITS / 8; ++k) state->code = (state->code << 8) | in[state->byte_index++];
+
+  for (i = 0; i < expected_size; ++i) {
+    uint64_t r = state->range >> state->frac_size;
+    uint64_t target = state->code / r;
+    if (target >> state->frac_size) target = state->cumul_table[256] - 1; // corrupted stream
+    int s = state->decode_table[target >> (state->frac_size - WIDE_LOOKUP_BITS)];
+
+    // the lookup gives the first symbol reaching the target slot
+    while (state->cumul_table[s + 1] <= target) s++;
+    out[i] = s;
+
+    state->code -= r * state->cumul_table[s];
+    state->range = r * (state->cumul_table[s + 1] - state->cumul_table[s]);
+
+    while (state->range < RANGE_BOTTOM) {
+      state->range <<= 8;
+      state->code = (state->code << 8) | in[state->byte_index++];
+    }
+  }
+}
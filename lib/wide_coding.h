@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** \defgroup wide_coding wide range coding
+ *  \brief Static range coding with a 64-bit state and 24 to 32-bit
+ *         probability precision, renormalized by bytes
+ *   @{
+ */
+
+/** minimal and maximal probability precision of the wide coder */
+#define WIDE_MIN_PRECISION 24
+#define WIDE_MAX_PRECISION 32
+
+/** log2 of the number of slots of the wide decoder symbol lookup table */
+#define WIDE_LOOKUP_BITS 12
+
+/** Wide range coder state (all arithmetic is unsigned) */
+typedef struct
+{
+  /** probability precision: the cumulative table sums to 1 << frac_size */
+  int frac_size;
+  /** cumulative frequency table (symbol s covers
+   *  [cumul_table[s], cumul_table[s + 1])) */
+  uint64_t cumul_table[257];
+  /** first symbol whose interval reaches each slot of the cumulative
+   *  range (decoder symbol lookup) */
+  unsigned char decode_table[1 << WIDE_LOOKUP_BITS];
+  /** coded interval low value (56 bits + carry) and range size, the range
+   *  is kept in [2^48, 2^56) by byte renormalization */
+  uint64_t low;
+  uint64_t range;
+  /** decoder offset of the code value in the coded interval */
+  uint64_t code;
+  /** byte held back for carry propagation, followed by cache_size - 1
+   *  0xff bytes */
+  unsigned char cache;
+  uint64_t cache_size;
+  /** index of the next byte to be written/read */
+  size_t byte_index;
+} wide_state_t;
+
+/** Initialize a wide coder state with uniform probabilities
+ *  @param state structure to be initialized
+ *  @param precision probability precision (WIDE_MIN_PRECISION to
+ *                   WIDE_MAX_PRECISION)
+ */
+void init_wide_state(wide_state_t* state, int precision);
+
+/** build the cumulative table of @p state from the occurences in @p in,
+ *  each symbol being given a non-zero frequency
+ *  @param state wide coder state
+ *  @param in reference input
+ *  @param size number of bytes in @p in
+ */
+void wide_build_probability_table(wide_state_t* state, const unsigned char* in, size_t size);
+
+/** Upper bound on the number of bytes written by encode_value_wide
+ *  @param size number of input bytes
+ *  @param precision probability precision of the coder
+ *  @return maximal encoded size (in bytes)
+ */
+size_t wide_bound(size_t size, int precision);
+
+/** Range coding of a byte-array with the static cumulative table of
+ *  @p state
+ *  @param out byte-array used as output stream (at least wide_bound bytes)
+ *  @param in input byte-array
+ *  @param size number of bytes in @p in
+ *  @param state wide coder state
+ *  @return number of bytes written to @p out
+ */
+size_t encode_value_wide(unsigned char* out, const unsigned char* in,
+                         size_t size, wide_state_t* state);
+
+/** Decoding of a byte-array generated by encode_value_wide with the same
+ *  cumulative table (the decoder does not read past the end of the coded
+ *  value)
+ *  @param out byte-array used as output stream
+ *  @param in input byte-array
+ *  @param state wide coder state
+ *  @param expected_size number of bytes to be decoded
+ */
+void decode_value_wide(unsigned char* out, const unsigned char* in,
+                       wide_state_t* state, size_t expected_size);
+
+/** @} */
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+
+/** Skewed token in [0, alphabet_size): small values are the most frequent
+ *  (as match lengths or distances) */
+static uint16_t random_token(int alphabet_size)
+{
+  int range = alphabet_size;
+  while (range > 2 && rand() % 4) range /= 2;
+  return rand() % range;
+}
+
+int main(void)
+{
+  // (precision, alphabet size)
+  const int configs[][2] = {{12, 2}, {16, 300}, {16, 4096}, {20, 4096}, {18, 65536}, {24, 65536}};
+  const size_t test_size[] = {0, 1, 1000, 1 << 18};
+  int c, i, lookup;
+
+  for (c = 0; c < 6; ++c) {
+    for (i = 0; i < 4; ++i) {
+      int precision = configs[c][0], alphabet_size = configs[c][1];
+      size_t local_size = test_size[i];
+      uint16_t* input  = malloc(sizeof(uint16_t) * (local_size + 1));
+      uint16_t* decomp = malloc(sizeof(uint16_t) * (local_size + 1));
+      unsigned char* output = malloc(encode_bound(2 * local_size, 24));
+      size_t j;
+
+      for (j = 0; j < local_size; ++j) input[j] = random_token(alphabet_size);
+
+      for (lookup = 0; lookup < 2; ++lookup) {
+        ac_state_t state;
+
+        printf("testing %d symbol alphabet (precision %d, lookup %d) on %zu symbols\n",
+               alphabet_size, precision, lookup, local_size);
+
+        init_state_alphabet(&state, precision, alphabet_size);
+        if (lookup) enable_decode_lookup(&state);
+
+        // static model
+        build_symbol_table(&state, input, local_size);
+        encode_symbols(output, input, local_size, &state);
+        size_t static_size = state.byte_index;
+        decode_symbols(decomp, output, &state, local_size);
+
+        if (memcmp(decomp, input, sizeof(uint16_t) * local_size)) {
+          printf("failure: static input/decomp do not match\n");
+          for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+          printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+          return 1;
+        }
+
+        // adaptive model, rebuilt every 4 * alphabet_size symbols
+        int update_range = 4 * alphabet_size;
+        init_encoding(&state);
+        reset_uniform_probability(&state);
+        encode_symbols_with_update(output, input, local_size, &state, update_range, 0);
+        size_t update_size = state.byte_index;
+        reset_uniform_probability(&state);
+        decode_symbols_with_update(decomp, output, &state, local_size, update_range, 0);
+
+        if (memcmp(decomp, input, sizeof(uint16_t) * local_size)) {
+          printf("failure: adaptive input/decomp do not match\n");
+          for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+          printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+          return 1;
+        }
+
+        printf("success: static %zu Bytes, adaptive %zu Bytes\n", static_size, update_size);
+
+        ac_free_state(&state);
+      }
+
+      free(input);
+      free(decomp);
+      free(output);
+    }
+  }
+
+  return 0;
+}
@@ -59,10 +59,57 @@ int main(void)
         printf("failure: reference/decomp do not match\n");
         for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
         printf("mismatch @ index %d, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        ac_free_state(&encoder_state);
+        free(input);
+        free(output);
+        free(decomp);
         return 1;
       } else {
         printf("success\n");
       }
+
+      printf("decoding with static table and symbol lookup\n");
+      memset(decomp, 0, local_size);
+      enable_decode_lookup(&encoder_state);
+      decode_value(decomp, output, &encoder_state, local_size);
+
+      if (memcmp(decomp, input, local_size)) {
+        printf("failure: reference/decomp do not match\n");
+        for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+        printf("mismatch @ index %d, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        ac_free_state(&encoder_state);
+        free(input);
+        free(output);
+        free(decomp);
+        return 1;
+      } else {
+        printf("success\n");
+      }
+
+      int lanes;
+      for (lanes = 2; lanes <= AC_MAX_LANES; lanes *= 2) {
+        printf("encoding/decoding with static table on %d interleaved lanes\n", lanes);
+        size_t interleaved_size = encode_value_interleaved(output, input, local_size, &encoder_state, lanes);
+        printf("compression ratio is %.3f%%\n", interleaved_size / (double) local_size * 100.0);
+
+        memset(decomp, 0, local_size);
+        decode_value_interleaved(decomp, output, &encoder_state, local_size);
+
+        if (memcmp(decomp, input, local_size)) {
+          printf("failure: reference/decomp do not match\n");
+          for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+          printf("mismatch @ index %d, %x vs %x (expected) \n", j, decomp[j], input[j]);
+          ac_free_state(&encoder_state);
+          free(input);
+          free(output);
+          free(decomp);
+          return 1;
+        } else {
+          printf("success\n");
+        }
+      }
+
+      ac_free_state(&encoder_state);
     }
 
     {
@@ -91,12 +138,40 @@ int main(void)
         printf("failure: reference/decomp do not match\n");
         for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
         printf("mismatch @ index %d, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        ac_free_state(&encoder_state);
+        free(input);
+        free(output);
+        free(decomp);
         return 1;
       } else {
         printf("success\n");
       }
 
+      enable_decode_lookup(&encoder_state);
+      reset_uniform_probability(&encoder_state);
+      printf("decoding with dynamic table and symbol lookup\n");
+      memset(decomp, 0, local_size);
+      decode_value_with_update(decomp, output, &encoder_state, local_size, update_range, range_clear);
+
+      if (memcmp(decomp, input, local_size)) {
+        printf("failure: reference/decomp do not match\n");
+        for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+        printf("mismatch @ index %d, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        ac_free_state(&encoder_state);
+        free(input);
+        free(output);
+        free(decomp);
+        return 1;
+      } else {
+        printf("success\n");
+      }
+
+      ac_free_state(&encoder_state);
     }
+
+    free(input);
+    free(output);
+    free(decomp);
   }
 
   {
@@ -133,12 +208,265 @@ int main(void)
 
     if (memcmp(decomp, reference, sizeof(reference))) {
       printf("failure: reference/decomp do not match\n");
+      ac_free_state(&encoder_state);
+      free(output);
+      free(decomp);
+      return 1;
+    } else {
+      printf("success\n");
+    }
+
+    ac_free_state(&encoder_state);
+    free(output);
+    free(decomp);
+  }
+
+  {
+    size_t  output_size = AC_TABLE_HEADER_BOUND + encode_bound(1 << 16, 16);
+    unsigned char* random = malloc(sizeof(unsigned char) * (1 << 16));
+    unsigned char* output = malloc(sizeof(unsigned char) * output_size);
+    unsigned char* decomp = malloc(sizeof(unsigned char) * (1 << 16));
+    const unsigned char* buffers[] = {input, random, input};
+    const size_t sizes[] = {sizeof(input), 1 << 16, 0};
+    int i, j;
+
+    for (j = 0; j < (1 << 16); ++j) random[j] = rand() % 256;
+
+    for (i = 0; i < 3; ++i) {
+      ac_state_t encoder_state, decoder_state;
+      init_state(&encoder_state, 16);
+      init_state(&decoder_state, 16);
+
+      printf("encoding %zu Bytes with a self-describing static table\n", sizes[i]);
+      size_t header_size  = store_probability_table(output, &encoder_state, buffers[i], sizes[i]);
+      size_t encoded_size = encode_value_with_table(output, buffers[i], sizes[i], &encoder_state);
+      printf("header is %zu Bytes, compression ratio is %.3f%%\n", header_size,
+             encoded_size / (double) (sizes[i] ? sizes[i] : 1) * 100.0);
+
+      printf("decoding with the serialized table\n");
+      decode_value_with_table(decomp, output, &decoder_state, sizes[i]);
+
+      if (memcmp(decomp, buffers[i], sizes[i]) ||
+          memcmp(decoder_state.cumul_table, encoder_state.cumul_table, sizeof(int) * 257)) {
+        printf("failure: reference/decomp do not match\n");
+        ac_free_state(&encoder_state);
+        ac_free_state(&decoder_state);
+        free(random);
+        free(output);
+        free(decomp);
+        return 1;
+      } else {
+        printf("success\n");
+      }
+      ac_free_state(&encoder_state);
+      ac_free_state(&decoder_state);
+    }
+
+    free(random);
+    free(output);
+    free(decomp);
+  }
+
+  // caller-provided storage: a state reset with ac_reset between messages
+  // must produce the same streams as freshly initialized states
+  {
+    size_t  output_size = encode_bound(sizeof(input), 16);
+    unsigned char* reference = malloc(sizeof(unsigned char) * output_size);
+    unsigned char* output    = malloc(sizeof(unsigned char) * output_size);
+    unsigned char* decomp    = malloc(sizeof(unsigned char) * sizeof(input));
+    ac_storage_t storage;
+    ac_state_t reused_state;
+    int i;
+
+    init_state_with_storage(&reused_state, 16, &storage);
+    enable_decode_lookup(&reused_state);
+
+    for (i = 0; i < 4; ++i) {
+      ac_state_t fresh_state;
+      init_state(&fresh_state, 16);
+      reset_uniform_probability(&fresh_state);
+      encode_value_with_update(reference, (unsigned char*) input, sizeof(input), &fresh_state, 64, i & 1);
+
+      printf("encoding with a reused state (message %d)\n", i);
+      ac_reset(&reused_state);
+      encode_value_with_update(output, (unsigned char*) input, sizeof(input), &reused_state, 64, i & 1);
+
+      if (reused_state.byte_index != fresh_state.byte_index ||
+          memcmp(output, reference, fresh_state.byte_index)) {
+        printf("failure: reused/fresh state outputs do not match\n");
+        ac_free_state(&fresh_state);
+        ac_free_state(&reused_state);
+        free(reference);
+        free(output);
+        free(decomp);
+        return 1;
+      }
+
+      ac_reset(&reused_state);
+      decode_value_with_update(decomp, output, &reused_state, sizeof(input), 64, i & 1);
+      if (memcmp(decomp, input, sizeof(input)) || reused_state.decode_table != storage.decode_table) {
+        printf("failure: reference/decomp do not match\n");
+        ac_free_state(&fresh_state);
+        ac_free_state(&reused_state);
+        free(reference);
+        free(output);
+        free(decomp);
+        return 1;
+      } else {
+        printf("success\n");
+      }
+      ac_free_state(&fresh_state);
+    }
+
+    ac_free_state(&reused_state);
+    free(reference);
+    free(output);
+    free(decomp);
+  }
+
+  // raw-store fallback: uniform random blocks are stored (one byte of
+  // expansion) without being coded, text is coded
+  {
+    const size_t random_size = 1 << 18;
+    unsigned char* random = malloc(random_size);
+    unsigned char* output = malloc(auto_bound(random_size));
+    unsigned char* decomp = malloc(random_size);
+    const unsigned char* buffers[] = {random, random, input, input};
+    const size_t sizes[] = {random_size, 100, sizeof(input), 0};
+    const int modes[] = {AC_BLOCK_RAW, AC_BLOCK_RAW, AC_BLOCK_CODED, AC_BLOCK_RAW};
+    ac_state_t state;
+    size_t j;
+    int i;
+
+    for (j = 0; j < random_size; ++j) random[j] = rand() % 256;
+    init_state(&state, 16);
+
+    for (i = 0; i < 4; ++i) {
+      printf("encoding %zu Bytes with raw-store fallback\n", sizes[i]);
+      size_t encoded_size = encode_value_auto(output, buffers[i], sizes[i], &state, 1024, 0);
+      printf("block mode %d, %zu Bytes (estimated %zu Bytes)\n", output[0], encoded_size,
+             estimate_coded_size(buffers[i], sizes[i]));
+
+      memset(decomp, 0, sizes[i]);
+      decode_value_auto(decomp, output, &state, sizes[i], 1024, 0);
+      if (output[0] != modes[i] || encoded_size > sizes[i] + 1 || memcmp(decomp, buffers[i], sizes[i])) {
+        printf("failure: unexpected block mode or reference/decomp do not match\n");
+        ac_free_state(&state);
+        free(random);
+        free(output);
+        free(decomp);
+        return 1;
+      } else {
+        printf("success\n");
+      }
+    }
+
+    ac_free_state(&state);
+    free(random);
+    free(output);
+    free(decomp);
+  }
+
+  // without range clear, the cumulative table must still be rebuilt only
+  // every update_range symbols: after coding the input, it is the table
+  // of the counts of the symbols before the last update
+  {
+    const int update_range = 64;
+    const size_t updated = sizeof(input) / update_range * update_range;
+    unsigned char* output = malloc(encode_bound(sizeof(input), 16));
+    ac_state_t state, expected;
+    size_t j;
+
+    printf("checking the cumulative table updates without range clear\n");
+    init_state(&state, 16);
+    reset_uniform_probability(&state);
+    encode_value_with_update(output, (unsigned char*) input, sizeof(input), &state, update_range, 0);
+
+    init_state(&expected, 16);
+    reset_prob_table(&expected);
+    for (j = 0; j < updated; ++j) expected.prob_table[input[j]]++;
+    transform_count_to_cumul(&expected, updated);
+
+    if (memcmp(state.cumul_table, expected.cumul_table, sizeof(int) * 257)) {
+      printf("failure: cumulative table updated between update ranges\n");
+      ac_free_state(&state);
+      ac_free_state(&expected);
+      free(output);
+      return 1;
+    } else {
+      printf("success\n");
+    }
+
+    ac_free_state(&state);
+    ac_free_state(&expected);
+    free(output);
+  }
+
+  // without range clear, counts exceed the precision: a rare symbol must
+  // still get a non-empty interval (at least 2 units of the cumulative table)
+  {
+    const size_t size = 1 << 18;
+    unsigned char* skewed = malloc(size);
+    unsigned char* output = malloc(encode_bound(size, 16));
+    unsigned char* decomp = malloc(size);
+    ac_state_t state;
+
+    printf("encoding %zu Bytes with a rare symbol without range clear\n", size);
+    memset(skewed, 'a', size);
+    skewed[size - 1] = 'b';
+    init_state(&state, 16);
+    reset_uniform_probability(&state);
+    encode_value_with_update(output, skewed, size, &state, 1024, 0);
+    size_t encoded_size = state.byte_index;
+    reset_uniform_probability(&state);
+    decode_value_with_update(decomp, output, &state, size, 1024, 0);
+
+    if (state.cumul_table['c'] - state.cumul_table['b'] < 2 || encoded_size > encode_bound(size, 16) ||
+        memcmp(decomp, skewed, size)) {
+      printf("failure: empty symbol interval or skewed/decomp do not match\n");
+      ac_free_state(&state);
+      free(skewed);
+      free(output);
+      free(decomp);
       return 1;
     } else {
       printf("success\n");
     }
+
+    ac_free_state(&state);
+    free(skewed);
+    free(output);
+    free(decomp);
   }
 
+  // estimate missed: without table update the (uniform) coded value
+  // reaches the input size, the coder must stop within auto_bound bytes
+  {
+    const size_t size = sizeof(input);
+    unsigned char* output = malloc(auto_bound(size));
+    unsigned char* decomp = malloc(size);
+    ac_state_t state;
+
+    printf("encoding %zu Bytes with a uniform model and raw-store fallback\n", size);
+    init_state(&state, 16);
+    size_t encoded_size = encode_value_auto(output, input, size, &state, 2 * size, 0);
+    decode_value_auto(decomp, output, &state, size, 2 * size, 0);
+
+    if (!estimate_compressible(input, size) || output[0] != AC_BLOCK_RAW ||
+        encoded_size != auto_bound(size) || memcmp(decomp, input, size)) {
+      printf("failure: unexpected block mode or input/decomp do not match\n");
+      ac_free_state(&state);
+      free(output);
+      free(decomp);
+      return 1;
+    } else {
+      printf("success\n");
+    }
+
+    ac_free_state(&state);
+    free(output);
+    free(decomp);
+  }
 
   return 0;
 }
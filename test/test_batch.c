@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "batch_coding.h"
+
+int main(void)
+{
+  const char text[] = "A reference work is a book or periodical (or its electronic equivalent) to which one can refer "
+                      "for confirmed facts. The information is intended to be found quickly when needed.";
+  const size_t record_counts[] = {0, 1, 10, 20000};
+  int i;
+
+  for (i = 0; i < 4; ++i) {
+    size_t count = record_counts[i];
+    ac_record_t* records = malloc(sizeof(ac_record_t) * (count + 1));
+    size_t* sizes   = malloc(sizeof(size_t) * (count + 1));
+    size_t* offsets = malloc(sizeof(size_t) * (count + 1));
+    size_t total = 0, j, k;
+
+    // records of 50 to 500 bytes (every 7th one being empty), stored
+    // contiguously so that the decoded batch can be compared to the input
+    for (j = 0; j < count; ++j) sizes[j] = j % 7 == 6 ? 0 : 50 + rand() % 451;
+    for (j = 0; j < count; ++j) total += sizes[j];
+    unsigned char* input  = malloc(total + 1);
+    unsigned char* decomp = malloc(total + 1);
+    for (j = 0; j < total; ++j) input[j] = text[rand() % (sizeof(text) - 1)];
+    for (j = 0, k = 0; j < count; k += sizes[j++]) {
+      records[j].data = input + k;
+      records[j].size = sizes[j];
+    }
+
+    size_t output_size = batch_bound(records, count, 16);
+    unsigned char* output = malloc(output_size);
+
+    printf("testing batch coding of %zu records (%zu Bytes)\n", count, total);
+
+    ac_state_t state;
+    init_state(&state, 16);
+
+    size_t encoded_size = encode_batch(output, records, count, &state, offsets);
+    enable_decode_lookup(&state);
+    decode_batch(decomp, output, offsets, sizes, count, &state);
+
+    if (encoded_size + AC_DECODE_PADDING > output_size || offsets[count] != encoded_size) {
+      printf("failure: %zu encoded bytes exceed batch_bound (%zu)\n", encoded_size, output_size);
+      return 1;
+    }
+    if (memcmp(decomp, input, total)) {
+      printf("failure: input/decomp do not match\n");
+      for (j = 0; j < total && decomp[j] == input[j]; ++j);
+      printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+      return 1;
+    }
+
+    // random access: records decoded individually in reverse order
+    memset(decomp, 0, total);
+    for (j = count; j-- > 0;) {
+      decode_batch_record(decomp, output, offsets, j, sizes[j], &state);
+      if (memcmp(decomp, records[j].data, sizes[j])) {
+        printf("failure: record %zu does not match\n", j);
+        return 1;
+      }
+    }
+    printf("success: %zu Bytes\n", encoded_size);
+
+    ac_free_state(&state);
+    free(records);
+    free(sizes);
+    free(offsets);
+    free(input);
+    free(output);
+    free(decomp);
+  }
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "binary_coding.h"
+
+/** Fill @p input with the bytes the binary coder predicts the least: each
+ *  bit is the least probable one at its bit-tree node */
+static void adversarial_input(unsigned char* input, size_t size)
+{
+  int prob[256];
+  size_t j;
+  int i;
+
+  for (i = 0; i < 256; ++i) prob[i] = 1 << (BIN_PROB_BITS - 1);
+
+  for (j = 0; j < size; ++j) {
+    int node = 1;
+    for (i = 0; i < 8; ++i) {
+      int bit = prob[node] >= (1 << (BIN_PROB_BITS - 1));
+      if (bit) prob[node] -= prob[node] >> BIN_MOVE_BITS;
+      else prob[node] += ((1 << BIN_PROB_BITS) - prob[node]) >> BIN_MOVE_BITS;
+      node = (node << 1) | bit;
+    }
+    input[j] = (unsigned char) node;
+  }
+}
+
+int main(void)
+{
+  const char text[] = "A reference work is a book or periodical (or its electronic equivalent) to which one can refer "
+                      "for confirmed facts. The information is intended to be found quickly when needed.";
+  const int test_size[] = {0, 1, 1000, 65536, 1 << 22};
+  int i, mode;
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 4; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(binary_bound(local_size) + encode_bound(local_size, 16));
+      unsigned char* decomp = malloc(local_size + 1);
+      size_t j;
+
+      // mode 0: uniform random, mode 1: text, mode 2: skewed, mode 3: adversarial
+      if (mode == 3) adversarial_input(input, local_size);
+      for (j = 0; j < local_size && mode < 3; ++j) {
+        input[j] = mode == 0 ? rand() % 256 : mode == 1 ? text[rand() % (sizeof(text) - 1)]
+                             : (rand() % 16 ? 'a' : rand() % 256);
+      }
+
+      printf("testing binary coder on %zu Bytes (mode %d)\n", local_size, mode);
+
+      ac_state_t state;
+      init_state(&state, 16);
+
+      size_t encoded_size = encode_value_binary(output, input, local_size, &state);
+      decode_value_binary(decomp, output, &state, local_size);
+
+      if (encoded_size > binary_bound(local_size)) {
+        printf("failure: %zu encoded bytes exceed binary_bound (%zu)\n", encoded_size, binary_bound(local_size));
+        return 1;
+      }
+      if (state.byte_index != encoded_size) {
+        printf("failure: %zu bytes read by the decoder, %zu encoded\n", state.byte_index, encoded_size);
+        return 1;
+      }
+      if (memcmp(decomp, input, local_size)) {
+        printf("failure: input/decomp do not match\n");
+        for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+        printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        return 1;
+      } else {
+        printf("success: %zu Bytes\n", encoded_size);
+      }
+
+      ac_free_state(&state);
+      free(input);
+      free(output);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
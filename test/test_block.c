@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "block_coding.h"
+
+int main(void)
+{
+  // (size, block size, threads) configurations
+  const size_t test_size[]  = {0, 1, 1000, 65536, 1 << 20, (1 << 20) + 17};
+  const size_t test_block[] = {1024, 1024, 300, 65536, 1 << 16, 100000};
+  const int test_threads[]  = {1, 2, 3, 4, 0, 8};
+  int i;
+
+  for (i = 0; i < 6; ++i) {
+    size_t local_size = test_size[i];
+    size_t block_size = test_block[i];
+    int threads = test_threads[i];
+    const int precision = 16, update_range = 128, range_clear = 0;
+
+    size_t output_size = parallel_bound(local_size, block_size);
+    unsigned char* input  = malloc(local_size + 1);
+    unsigned char* output = malloc(output_size);
+    unsigned char* decomp = malloc(local_size + 1);
+
+    printf("testing block-parallel AC on %zu Bytes (blocks of %zu Bytes, %d threads)\n",
+           local_size, block_size, threads);
+
+    // skewed test data
+    size_t j;
+    for (j = 0; j < local_size; ++j) input[j] = (rand() % 7) * (rand() % 5) + (j % 300 == 0 ? rand() % 256 : 0);
+
+    size_t encoded_size = encode_parallel(output, input, local_size, block_size, precision,
+                                          update_range, range_clear, threads);
+    printf("compression ratio is %.3f%%\n", local_size ? encoded_size * 100.0 / local_size : 0.0);
+
+    // the container is decoded from a buffer of its exact size
+    unsigned char* container = malloc(encoded_size);
+    memcpy(container, output, encoded_size);
+    decode_parallel(decomp, container, local_size, precision, update_range, range_clear, threads);
+
+    if (memcmp(decomp, input, local_size)) {
+      printf("failure: input/decomp do not match\n");
+      for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+      printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+      return 1;
+    } else {
+      printf("success\n");
+    }
+
+    // random access: ranges within a block, across blocks and up to the end
+    for (j = 0; j < 20 && local_size; ++j) {
+      size_t offset = j ? rand() % local_size : 0;
+      size_t length = j % 4 == 3 ? local_size - offset : rand() % (local_size - offset + 1) % (3 * block_size);
+      memset(decomp, 0, local_size);
+      decode_range(decomp, container, local_size, offset, length, precision, update_range, range_clear);
+      if (memcmp(decomp, input + offset, length)) {
+        printf("failure: range [%zu, %zu) does not match\n", offset, offset + length);
+        return 1;
+      }
+    }
+
+    free(input);
+    free(output);
+    free(container);
+    free(decomp);
+  }
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "fenwick_model.h"
+#include "context_model.h"
+
+int main(void)
+{
+  const char* words[] = {"reference", "work", "is", "a", "book", "or", "periodical", "to", "which",
+                         "one", "can", "refer", "for", "confirmed", "facts", "information", "the",
+                         "intended", "found", "quickly", "when", "needed", "[info]", "[warn]"};
+  const int word_count = sizeof(words) / sizeof(words[0]);
+  const int test_size[] = {0, 1, 1000, 65536, 1 << 21};
+  // (order, context bits), order 0 being the plain Fenwick model
+  const int configs[][2] = {{0, 0}, {1, 8}, {2, 16}, {2, 12}};
+  int i, mode, c;
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 2; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(encode_bound(local_size, 16));
+      unsigned char* decomp = malloc(local_size + 1);
+      size_t j = 0;
+
+      // mode 0: uniform random, mode 1: text made of random words
+      while (j < local_size) {
+        if (mode == 0) input[j++] = rand() % 256;
+        else {
+          const char* word = words[rand() % word_count];
+          while (*word && j < local_size) input[j++] = *word++;
+          if (j < local_size) input[j++] = rand() % 8 ? ' ' : '\n';
+        }
+      }
+
+      for (c = 0; c < 4; ++c) {
+        ac_state_t state;
+        fenwick_model_t order0;
+        context_model_t model;
+        size_t encoded_size;
+
+        printf("testing order-%d model (%d context bits) on %zu Bytes (mode %d)\n",
+               configs[c][0], configs[c][1], local_size, mode);
+
+        init_state(&state, 16);
+        if (configs[c][0] == 0) {
+          init_fenwick_model(&order0, 32, 1 << 15);
+          encode_value_fenwick(output, input, local_size, &state, &order0);
+        } else {
+          init_context_model(&model, configs[c][0], configs[c][1], 32, 1 << 15);
+          encode_value_context(output, input, local_size, &state, &model);
+        }
+        encoded_size = state.byte_index;
+
+        if (configs[c][0] == 0) {
+          init_fenwick_model(&order0, 32, 1 << 15);
+          decode_value_fenwick(decomp, output, &state, &order0, local_size);
+        } else {
+          size_t allocated = model.allocated;
+          reset_context_model(&model);
+          decode_value_context(decomp, output, &state, &model, local_size);
+          if (model.allocated != allocated) {
+            printf("failure: %zu contexts allocated by the decoder, %zu by the encoder\n",
+                   model.allocated, allocated);
+            return 1;
+          }
+        }
+
+        if (encoded_size > encode_bound(local_size, 16) || memcmp(decomp, input, local_size)) {
+          printf("failure: coded size exceeds the bound or input/decomp do not match\n");
+          for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+          printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+          return 1;
+        } else {
+          printf("success\n");
+        }
+
+        printf("%zu Bytes", encoded_size);
+        if (configs[c][0]) {
+          printf(", %zu contexts (%zu KB)", model.allocated, model.allocated * sizeof(fenwick_model_t) / 1024);
+          free_context_model(&model);
+        }
+        printf("\n");
+
+        ac_free_state(&state);
+      }
+
+      free(input);
+      free(output);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+
+int main(void)
+{
+  const char text[] = "A reference work is a book or periodical (or its electronic equivalent) to which one can refer "
+                      "for confirmed facts. The information is intended to be found quickly when needed.";
+  const int test_size[] = {0, 1, 1000, 65536, 1 << 21};
+  // (precision, window bits, decay shift)
+  const int configs[][3] = {{16, 6, 4}, {16, 10, 2}, {16, 10, 0}, {12, 6, 2}, {20, 8, 3}};
+  int i, mode, c;
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 3; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(encode_bound(local_size, 20));
+      unsigned char* decomp = malloc(local_size + 1);
+      size_t j;
+
+      // mode 0: uniform random, mode 1: text, mode 2: drifting (the dominant
+      // symbol changes every 4096 bytes)
+      for (j = 0; j < local_size; ++j) {
+        input[j] = mode == 0 ? rand() % 256 : mode == 1 ? text[rand() % (sizeof(text) - 1)]
+                             : (rand() % 8 ? 'a' + (j / 4096) % 26 : rand() % 256);
+      }
+
+      for (c = 0; c < 5; ++c) {
+        int precision = configs[c][0], window_bits = configs[c][1], decay_shift = configs[c][2];
+        ac_state_t state;
+
+        printf("testing decay model (precision %d, window 2^%d, decay 2^-%d) on %zu Bytes (mode %d)\n",
+               precision, window_bits, decay_shift, local_size, mode);
+
+        init_state(&state, precision);
+        enable_decode_lookup(&state);
+        encode_value_with_decay(output, input, local_size, &state, window_bits, decay_shift);
+        size_t encoded_size = state.byte_index;
+        decode_value_with_decay(decomp, output, &state, local_size, window_bits, decay_shift);
+
+        if (state.cumul_table[256] != (1 << precision)) {
+          printf("failure: model total is %d\n", state.cumul_table[256]);
+          return 1;
+        }
+        if (encoded_size > encode_bound(local_size, precision) || memcmp(decomp, input, local_size)) {
+          printf("failure: coded size exceeds the bound or input/decomp do not match\n");
+          for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+          printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+          return 1;
+        } else {
+          printf("success: %zu Bytes\n", encoded_size);
+        }
+
+        ac_free_state(&state);
+      }
+
+      free(input);
+      free(output);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "fenwick_model.h"
+
+int main(void)
+{
+  const char text[] = "A reference work is a book or periodical (or its electronic equivalent) to which one can refer "
+                      "for confirmed facts. The information is intended to be found quickly when needed.";
+  const int test_size[] = {0, 1, 1000, 65536, 1 << 21};
+  int i, mode;
+
+  // model consistency: tree descent against prefix sums
+  {
+    fenwick_model_t model;
+    int s;
+
+    init_fenwick_model(&model, 24, 1 << 15);
+    for (i = 0; i < 100000; ++i) fenwick_update(&model, rand() % 7 ? 'e' : rand() % 256);
+
+    uint32_t sum = 0;
+    for (s = 0; s < FENWICK_SYMBOLS; ++s) {
+      uint32_t cum_low, freq = fenwick_frequency(&model, s);
+      if (freq == 0 || fenwick_cumul(&model, s) != sum ||
+          fenwick_find(&model, sum + freq - 1, &cum_low) != s || cum_low != sum) {
+        printf("failure: inconsistent model for symbol %d\n", s);
+        return 1;
+      }
+      sum += freq;
+    }
+    if (sum != model.total || model.total > model.limit) {
+      printf("failure: model total %u does not match frequencies (%u)\n", model.total, sum);
+      return 1;
+    }
+  }
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 3; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(encode_bound(local_size, 16));
+      unsigned char* decomp = malloc(local_size + 1);
+      size_t j;
+
+      // mode 0: uniform random, mode 1: text, mode 2: drifting (the dominant
+      // symbol changes every 4096 bytes)
+      for (j = 0; j < local_size; ++j) {
+        input[j] = mode == 0 ? rand() % 256 : mode == 1 ? text[rand() % (sizeof(text) - 1)]
+                             : (rand() % 8 ? 'a' + (j / 4096) % 26 : rand() % 256);
+      }
+
+      printf("testing Fenwick model on %zu Bytes (mode %d)\n", local_size, mode);
+
+      ac_state_t state;
+      fenwick_model_t model;
+
+      init_state(&state, 16);
+      init_fenwick_model(&model, 24, 1 << 15);
+      encode_value_fenwick(output, input, local_size, &state, &model);
+      size_t encoded_size = state.byte_index;
+
+      init_fenwick_model(&model, 24, 1 << 15);
+      decode_value_fenwick(decomp, output, &state, &model, local_size);
+
+      if (encoded_size > encode_bound(local_size, 16) || memcmp(decomp, input, local_size)) {
+        printf("failure: coded size exceeds the bound or input/decomp do not match\n");
+        for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+        printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        return 1;
+      } else {
+        printf("success: %zu Bytes\n", encoded_size);
+      }
+
+      ac_free_state(&state);
+      free(input);
+      free(output);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "histogram.h"
+
+int main(void)
+{
+  const size_t test_size[] = {0, 1, 15, 17, 1000, 65536 + 7, (1 << 24) + 3};
+  const int thread_count[] = {1, 2, 4, 0};
+  int i, mode, t;
+
+  for (i = 0; i < 7; ++i) {
+    for (mode = 0; mode < 3; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input = malloc(local_size + 1);
+      size_t reference[256] = {0};
+      size_t count[256];
+      size_t j;
+
+      // mode 0: uniform random, mode 1: skewed, mode 2: constant
+      for (j = 0; j < local_size; ++j) {
+        input[j] = mode == 0 ? rand() % 256 : mode == 1 ? (rand() % 16 ? 'a' : rand() % 256) : 'a';
+      }
+
+      printf("testing histogram on %zu Bytes (mode %d)\n", local_size, mode);
+
+      for (j = 0; j < local_size; ++j) reference[input[j]]++;
+
+      for (t = 0; t < 4; ++t) {
+        memset(count, 0xff, sizeof(count));
+        ac_histogram(count, input, local_size, thread_count[t]);
+
+        if (memcmp(count, reference, sizeof(count))) {
+          printf("failure: histogram with %d threads does not match\n", thread_count[t]);
+          return 1;
+        }
+      }
+      printf("success\n");
+
+      free(input);
+    }
+  }
+
+  return 0;
+}
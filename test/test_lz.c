@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "lz_coding.h"
+
+/** Fill @p out with @p size bytes of log-like lines: a counter and a few
+ *  random words */
+static void generate_log(unsigned char* out, size_t size)
+{
+  const char* words[] = {"[info]", "[warn]", "request", "served", "in", "ms", "from", "cache",
+                         "connection", "closed", "by", "peer", "user", "login", "failed"};
+  const int word_count = sizeof(words) / sizeof(words[0]);
+  char line[128];
+  size_t j = 0;
+  int n = 0;
+
+  while (j < size) {
+    int length = sprintf(line, "2024-01-01 12:%02d:%02d ", (n / 60) % 60, n % 60);
+    int w;
+    for (w = 0; w < 4; ++w) length += sprintf(line + length, "%s ", words[rand() % word_count]);
+    line[length - 1] = '\n';
+    for (w = 0; w < length && j < size; ++w) out[j++] = line[w];
+    n++;
+  }
+}
+
+int main(void)
+{
+  const int test_size[] = {0, 1, 1000, 65536, 1 << 20};
+  // (window bits, max chain)
+  const int configs[][2] = {{8, 1}, {16, 1}, {16, 16}, {20, 64}, {24, 256}};
+  int i, mode, c;
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 3; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(lz_bound(local_size, 16));
+      unsigned char* decomp = malloc(local_size + 1);
+      ac_state_t state;
+      size_t j;
+
+      // mode 0: uniform random, mode 1: log lines, mode 2: runs of a byte
+      if (mode == 1) generate_log(input, local_size);
+      for (j = 0; mode != 1 && j < local_size; ++j) input[j] = mode == 0 ? rand() % 256 : 'a' + (j / 1000) % 4;
+
+      init_state(&state, 16);
+
+      for (c = 0; c < 5; ++c) {
+        int window_bits = configs[c][0], max_chain = configs[c][1];
+
+        printf("testing LZ coding (window 2^%d, chain %d) on %zu Bytes (mode %d)\n",
+               window_bits, max_chain, local_size, mode);
+
+        init_encoding(&state);
+        encode_value_lz(output, input, local_size, &state, window_bits, max_chain);
+        size_t encoded_size = state.byte_index;
+        memset(decomp, 0, local_size);
+        decode_value_lz(decomp, output, &state, local_size);
+
+        if (encoded_size > lz_bound(local_size, 16) || memcmp(decomp, input, local_size)) {
+          printf("failure: coded size exceeds the bound or input/decomp do not match\n");
+          for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+          printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+          return 1;
+        }
+        printf("success: %zu Bytes\n", encoded_size);
+      }
+
+      ac_free_state(&state);
+      free(input);
+      free(output);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "context_model.h"
+#include "model_file.h"
+
+/** Fill @p out with @p size bytes of text made of random words */
+static void generate_text(unsigned char* out, size_t size)
+{
+  const char* words[] = {"reference", "work", "is", "a", "book", "or", "periodical", "to", "which",
+                         "one", "can", "refer", "for", "confirmed", "facts", "information", "the",
+                         "intended", "found", "quickly", "when", "needed", "[info]", "[warn]"};
+  const int word_count = sizeof(words) / sizeof(words[0]);
+  size_t j = 0;
+
+  while (j < size) {
+    const char* word = words[rand() % word_count];
+    while (*word && j < size) out[j++] = *word++;
+    if (j < size) out[j++] = rand() % 8 ? ' ' : '\n';
+  }
+}
+
+int main(void)
+{
+  const char* filename = "test_model.acm";
+  const size_t sample_size = 1 << 20, message_size = 2000;
+  const int orders[] = {0, 1, 2};
+  int i;
+
+  unsigned char* sample  = malloc(sample_size);
+  unsigned char* message = malloc(message_size);
+  unsigned char* output    = malloc(encode_bound(message_size, 16));
+  unsigned char* reference = malloc(encode_bound(message_size, 16));
+  unsigned char* decomp  = malloc(message_size);
+  generate_text(sample, sample_size);
+  generate_text(message, message_size);
+
+  for (i = 0; i < 3; ++i) {
+    int order = orders[i], context_bits = order == 2 ? 16 : 8;
+    ac_model_t model;
+
+    printf("testing order-%d model file\n", order);
+
+    if (!ac_write_model(filename, sample, sample_size, 16, order, context_bits, 32, 1 << 15)) {
+      printf("failure: can not write model file\n");
+      return 1;
+    }
+    if (!ac_load_model(&model, filename)) {
+      printf("failure: can not load model file\n");
+      return 1;
+    }
+
+    // static coding with the mapped order-0 tables, against a state
+    // trained in memory
+    ac_state_t state, trained;
+    init_state_with_model(&state, &model);
+    init_state(&trained, 16);
+    build_probability_table(&trained, sample, sample_size);
+
+    encode_value(output, message, message_size, &state);
+    size_t encoded_size = state.byte_index;
+    init_encoding(&trained);
+    encode_value(reference, message, message_size, &trained);
+    decode_value(decomp, output, &state, message_size);
+
+    if (encoded_size != trained.byte_index || memcmp(output, reference, encoded_size) ||
+        memcmp(decomp, message, message_size)) {
+      printf("failure: order-0 model does not match the trained tables\n");
+      return 1;
+    }
+    printf("order-0: %zu Bytes\n", encoded_size);
+
+    if (order) {
+      context_model_t context, trained_context, untrained_context;
+
+      init_context_model_with_model(&context, &model);
+      init_context_model(&trained_context, order, context_bits, 32, 1 << 15);
+      train_context_model(&trained_context, sample, sample_size);
+      trained_context.history = 0;
+      init_context_model(&untrained_context, order, context_bits, 32, 1 << 15);
+
+      init_encoding(&state);
+      encode_value_context(output, message, message_size, &state, &context);
+      encoded_size = state.byte_index;
+      init_encoding(&state);
+      encode_value_context(reference, message, message_size, &state, &trained_context);
+      if (encoded_size != state.byte_index || memcmp(output, reference, encoded_size)) {
+        printf("failure: context models do not match the trained ones\n");
+        return 1;
+      }
+
+      reset_context_model(&context);
+      decode_value_context(decomp, output, &state, &context, message_size);
+      if (memcmp(decomp, message, message_size)) {
+        printf("failure: input/decomp do not match\n");
+        return 1;
+      }
+
+      init_encoding(&state);
+      encode_value_context(reference, message, message_size, &state, &untrained_context);
+      printf("order-%d: %zu Bytes (%zu Bytes without training)\n", order, encoded_size, state.byte_index);
+
+      free_context_model(&context);
+      free_context_model(&trained_context);
+      free_context_model(&untrained_context);
+    }
+
+    printf("success: %zu Bytes model\n", model.map_size);
+
+    ac_free_state(&state);
+    ac_free_state(&trained);
+    ac_unload_model(&model);
+  }
+
+  // invalid model file
+  {
+    ac_model_t model;
+    FILE* file = fopen(filename, "wb");
+    fwrite(sample, 1, 4096, file);
+    fclose(file);
+    if (ac_load_model(&model, filename)) {
+      printf("failure: invalid model file loaded\n");
+      return 1;
+    }
+  }
+
+  // corrupted header fields and tables of a valid order-1 model file
+  {
+    ac_model_t model;
+    ac_write_model(filename, sample, sample_size, 16, 1, 8, 32, 1 << 15);
+    if (!ac_load_model(&model, filename)) {
+      printf("failure: can not load model file\n");
+      return 1;
+    }
+
+    size_t size = model.map_size;
+    unsigned char* image = malloc(size);
+    memcpy(image, model.map, size);
+    size_t cumul_offset   = (const unsigned char*) model.cumul_table - model.map;
+    size_t decode_offset  = (const unsigned char*) model.decode_table - model.map;
+    size_t index_offset   = (const unsigned char*) model.context_index - model.map;
+    size_t context_offset = (const unsigned char*) model.contexts - model.map;
+    size_t trained = 0, slot = 0;
+    while (!model.context_index[trained]) trained++;
+    while (model.decode_table[slot] == model.decode_table[slot + 1]) slot++;
+    uint16_t next_symbol = model.decode_table[slot + 1];
+    ac_unload_model(&model);
+
+    for (i = 0; i < 8; ++i) {
+      unsigned char* corrupted = malloc(size);
+      uint32_t field = 200;
+      memcpy(corrupted, image, size);
+
+      switch (i) {
+      case 0: memcpy(corrupted + 12, &field, 4); break;  // decode_bits
+      case 1: memcpy(corrupted + 20, &field, 4); break;  // context_bits
+      case 2: ((int*) (corrupted + cumul_offset))[100] = -1; break;
+      case 3: ((uint16_t*) (corrupted + decode_offset))[5] = 300; break;
+      // still a non-decreasing table of symbols, but not the cumul_table one
+      case 7: ((uint16_t*) (corrupted + decode_offset))[slot] = next_symbol; break;
+      case 4: ((uint32_t*) (corrupted + index_offset))[trained] = 1000; break;
+      case 5: ((fenwick_model_t*) (corrupted + context_offset))->tree[1] += 7; break;
+      default: ((fenwick_model_t*) (corrupted + context_offset))->total += 1; break;
+      }
+
+      FILE* file = fopen(filename, "wb");
+      fwrite(corrupted, 1, size, file);
+      fclose(file);
+      if (ac_load_model(&model, filename)) {
+        printf("failure: corrupted model file loaded (case %d)\n", i);
+        return 1;
+      }
+      free(corrupted);
+    }
+    printf("success: corrupted model files rejected\n");
+    free(image);
+  }
+
+  remove(filename);
+  free(sample);
+  free(message);
+  free(output);
+  free(reference);
+  free(decomp);
+
+  return 0;
+}
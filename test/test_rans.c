@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+#include "rans_coding.h"
+
+int main(void)
+{
+  const char text[] = "A reference work is a book or periodical (or its electronic equivalent) to which one can refer "
+                      "for confirmed facts. The information is intended to be found quickly when needed.";
+  const int test_size[] = {0, 1, 1000, 65536, 1 << 22};
+  int i, mode;
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 3; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(rans_bound(local_size, 16) + encode_bound(local_size, 16));
+      unsigned char* decomp = malloc(local_size + 1);
+      size_t j;
+
+      // mode 0: uniform random, mode 1: text, mode 2: skewed
+      for (j = 0; j < local_size; ++j) {
+        input[j] = mode == 0 ? rand() % 256 : mode == 1 ? text[rand() % (sizeof(text) - 1)]
+                             : (rand() % 16 ? 'a' : rand() % 256);
+      }
+
+      printf("testing rANS on %zu Bytes (mode %d)\n", local_size, mode);
+
+      ac_state_t state;
+      init_state(&state, 16);
+      if (mode == 0) reset_uniform_probability(&state);
+      else build_probability_table(&state, input, local_size);
+
+      size_t encoded_size = rans_encode_value(output, input, local_size, &state);
+      rans_decode_value(decomp, output, &state, local_size);
+
+      if (encoded_size > rans_bound(local_size, 16) || memcmp(decomp, input, local_size)) {
+        printf("failure: coded size exceeds the bound or input/decomp do not match\n");
+        for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+        printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        return 1;
+      }
+
+      enable_decode_lookup(&state);
+      memset(decomp, 0, local_size);
+      rans_decode_value(decomp, output, &state, local_size);
+
+      if (memcmp(decomp, input, local_size)) {
+        printf("failure: input/decomp do not match (symbol lookup)\n");
+        return 1;
+      } else {
+        printf("success: %zu Bytes\n", encoded_size);
+      }
+
+      ac_free_state(&state);
+      free(input);
+      free(output);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
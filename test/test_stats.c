@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+
+/** Display the statistics collected by @p state */
+static void display_stats(ac_state_t* state)
+{
+  ac_stats_t stats;
+
+  ac_get_stats(state, &stats);
+  printf("symbols=%llu renorm_bits=%llu carries=%llu (%llu digits, longest %llu)\n",
+         (unsigned long long) stats.symbols, (unsigned long long) stats.renorm_bits,
+         (unsigned long long) stats.carries, (unsigned long long) stats.carry_digits,
+         (unsigned long long) stats.max_carry_digits);
+  printf("table rebuilds=%llu (%.3f ms), information cost %.1f bits, entropy %.1f bits, coded %d bits\n",
+         (unsigned long long) stats.table_rebuilds, stats.rebuild_ns * 1e-6, stats.info_bits,
+         ac_stats_entropy(&stats), state->out_index);
+}
+
+int main(void)
+{
+  const char text[] = "A reference work is a book or periodical (or its electronic equivalent) to which one can refer "
+                      "for confirmed facts. The information is intended to be found quickly when needed.";
+  const size_t size = 1 << 18;
+  unsigned char* input  = malloc(size);
+  unsigned char* output = malloc(encode_bound(size, 16));
+  unsigned char* decomp = malloc(size);
+  ac_state_t state;
+  ac_stats_t stats;
+  size_t j;
+
+  for (j = 0; j < size; ++j) input[j] = text[rand() % (sizeof(text) - 1)];
+
+  init_state(&state, 16);
+  if (!ac_get_stats(&state, &stats)) {
+    // statistics compiled out: the query reports zeroed counters
+    int status = stats.symbols || stats.info_bits != 0.0;
+    for (j = 0; j < sizeof(stats.symbol_count) / sizeof(stats.symbol_count[0]); ++j) {
+      if (stats.symbol_count[j]) status = 1;
+    }
+    printf("statistics disabled (build with make STATS=1)\n");
+
+    ac_free_state(&state);
+    free(input);
+    free(output);
+    free(decomp);
+    return status;
+  }
+
+  printf("encoding with dynamic table\n");
+  reset_uniform_probability(&state);
+  encode_value_with_update(output, input, size, &state, 1024, 1);
+  display_stats(&state);
+
+  ac_get_stats(&state, &stats);
+  if (stats.symbols != size || stats.table_rebuilds != size / 1024 ||
+      stats.renorm_bits > (uint64_t) state.out_index || stats.info_bits < ac_stats_entropy(&stats) ||
+      stats.info_bits > state.out_index) {
+    printf("failure: inconsistent encoding statistics\n");
+    ac_free_state(&state);
+    free(input);
+    free(output);
+    free(decomp);
+    return 1;
+  }
+
+  printf("decoding with dynamic table\n");
+  ac_reset_stats(&state);
+  reset_uniform_probability(&state);
+  decode_value_with_update(decomp, output, &state, size, 1024, 1);
+  display_stats(&state);
+
+  ac_stats_t decode_stats;
+  ac_get_stats(&state, &decode_stats);
+  if (memcmp(decomp, input, size) || decode_stats.symbols != size ||
+      memcmp(decode_stats.symbol_count, stats.symbol_count, sizeof(stats.symbol_count))) {
+    printf("failure: inconsistent decoding statistics\n");
+    ac_free_state(&state);
+    free(input);
+    free(output);
+    free(decomp);
+    return 1;
+  } else {
+    printf("success\n");
+  }
+
+  ac_free_state(&state);
+  free(input);
+  free(output);
+  free(decomp);
+
+  return 0;
+}
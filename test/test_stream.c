@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arith_coding.h"
+
+/** Encode @p input by chunks of random sizes (at most @p max_chunk input
+ *  and output bytes per call) */
+static size_t stream_encode(unsigned char* output, const unsigned char* input, size_t size,
+                            ac_state_t* state, int max_chunk)
+{
+  size_t in_pos = 0, out_pos = 0;
+  int done = 0;
+  while (!done) {
+    size_t in_len  = rand() % (max_chunk + 1);
+    size_t out_cap = rand() % (max_chunk + 1);
+    size_t consumed, produced;
+    if (in_len > size - in_pos) in_len = size - in_pos;
+    done = ac_encode_stream(state, input + in_pos, in_len, output + out_pos, out_cap,
+                            &consumed, &produced, in_pos + in_len == size);
+    assert(consumed <= in_len && produced <= out_cap);
+    in_pos  += consumed;
+    out_pos += produced;
+  }
+  return out_pos;
+}
+
+/** Decode @p size bytes from @p input by chunks of random sizes */
+static void stream_decode(unsigned char* decomp, size_t size, const unsigned char* input,
+                          size_t encoded_size, ac_state_t* state, int max_chunk)
+{
+  size_t in_pos = 0, out_pos = 0;
+  while (out_pos < size) {
+    size_t in_len  = rand() % (max_chunk + 1);
+    size_t out_cap = rand() % (max_chunk + 1);
+    size_t consumed, produced;
+    if (in_len > encoded_size - in_pos) in_len = encoded_size - in_pos;
+    if (out_cap > size - out_pos) out_cap = size - out_pos;
+    ac_decode_stream(state, input + in_pos, in_len, decomp + out_pos, out_cap,
+                     &consumed, &produced, in_pos + in_len == encoded_size);
+    in_pos  += consumed;
+    out_pos += produced;
+  }
+}
+
+int main(void)
+{
+  const char text[] = "Reference works are usually referred to for particular pieces of information, "
+                      "rather than read beginning to end.";
+  const int test_size[] = {0, 1, 100, 5000, 100000};
+  const int max_chunk[] = {3, 1, 7, 16, 200};
+  int i, mode;
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 3; ++mode) {
+      size_t local_size = test_size[i] + (mode == 2 ? 20000 : 0);
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(2 * local_size + 64);
+      unsigned char* stream = malloc(2 * local_size + 64);
+      unsigned char* decomp = malloc(local_size + 1);
+      size_t j;
+
+      // mode 2 contains a long run of the last symbol, which leads to a
+      // long carry chain with uniform probabilities
+      for (j = 0; j < local_size; ++j) input[j] = text[j % (sizeof(text) - 1)];
+      if (mode == 2) memset(input + local_size / 2 - 10000, 0xff, 20000);
+
+      const int update_range = mode == 1 ? 64 : 0;
+      printf("testing streaming AC on %zu Bytes (%s table, chunks of at most %d Bytes)\n",
+             local_size, update_range ? "dynamic" : "static", max_chunk[i]);
+
+      // one-shot reference
+      ac_state_t state;
+      init_state(&state, 16);
+      if (mode == 2) reset_uniform_probability(&state);
+      else build_probability_table(&state, (const unsigned char*) text, sizeof(text));
+      if (update_range) {
+        reset_uniform_probability(&state);
+        encode_value_with_update(output, input, local_size, &state, update_range, 0);
+      } else {
+        encode_value(output, input, local_size, &state);
+      }
+      size_t encoded_size = state.byte_index;
+
+      init_stream(&state, update_range, 0);
+      size_t stream_size = stream_encode(stream, input, local_size, &state, max_chunk[i]);
+
+      if (stream_size != encoded_size || memcmp(stream, output, encoded_size)) {
+        printf("failure: streaming and one-shot encoding do not match (%zu vs %zu Bytes)\n",
+               stream_size, encoded_size);
+        return 1;
+      }
+
+      init_stream(&state, update_range, 0);
+      stream_decode(decomp, local_size, stream, stream_size, &state, max_chunk[i]);
+
+      if (memcmp(decomp, input, local_size)) {
+        printf("failure: input/decomp do not match\n");
+        for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+        printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+        return 1;
+      } else {
+        printf("success\n");
+      }
+
+      ac_free_state(&state);
+      free(input);
+      free(output);
+      free(stream);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
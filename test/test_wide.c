@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "wide_coding.h"
+
+int main(void)
+{
+  const char text[] = "A reference work is a book or periodical (or its electronic equivalent) to which one can refer "
+                      "for confirmed facts. The information is intended to be found quickly when needed.";
+  const int test_size[] = {0, 1, 1000, 65536, 1 << 22};
+  const int precision[] = {24, 28, 32};
+  int i, mode, p;
+
+  for (i = 0; i < 5; ++i) {
+    for (mode = 0; mode < 4; ++mode) {
+      size_t local_size = test_size[i];
+      unsigned char* input  = malloc(local_size + 1);
+      unsigned char* output = malloc(wide_bound(local_size, WIDE_MAX_PRECISION));
+      unsigned char* decomp = malloc(local_size + 1);
+      size_t j;
+
+      // mode 0: uniform random, mode 1: text, mode 2: skewed, mode 3: highly
+      // skewed (1 byte in 10000 differs)
+      for (j = 0; j < local_size; ++j) {
+        input[j] = mode == 0 ? rand() % 256 : mode == 1 ? text[rand() % (sizeof(text) - 1)]
+                 : mode == 2 ? (rand() % 16 ? 'a' : rand() % 256) : (rand() % 10000 ? 'a' : rand() % 256);
+      }
+
+      for (p = 0; p < 3; ++p) {
+        wide_state_t wide;
+
+        printf("testing wide coder (precision %d) on %zu Bytes (mode %d)\n", precision[p], local_size, mode);
+
+        init_wide_state(&wide, precision[p]);
+        wide_build_probability_table(&wide, input, local_size);
+
+        size_t encoded_size = encode_value_wide(output, input, local_size, &wide);
+        decode_value_wide(decomp, output, &wide, local_size);
+
+        if (encoded_size > wide_bound(local_size, precision[p]) || wide.byte_index != encoded_size) {
+          printf("failure: %zu encoded bytes, %zu read by the decoder\n", encoded_size, wide.byte_index);
+          return 1;
+        }
+        if (memcmp(decomp, input, local_size)) {
+          printf("failure: input/decomp do not match\n");
+          for (j = 0; j < local_size && decomp[j] == input[j]; ++j);
+          printf("mismatch @ index %zu, %x vs %x (expected) \n", j, decomp[j], input[j]);
+          return 1;
+        } else {
+          printf("success: %zu Bytes\n", encoded_size);
+        }
+      }
+
+      free(input);
+      free(output);
+      free(decomp);
+    }
+  }
+
+  return 0;
+}
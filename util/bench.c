@@ -0,0 +1,394 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <assert.h>
+
+#include <unistd.h>
+
+#include "arith_coding.h"
+#include "binary_coding.h"
+#include "rans_coding.h"
+#include "fenwick_model.h"
+#include "context_model.h"
+#include "lz_coding.h"
+#include "wide_coding.h"
+
+/** Reproducible throughput benchmark: deterministic synthetic corpora are
+ *  coded by each engine/parameter set, timings being reported as CSV
+ *  (one line per corpus, size and configuration) on the standard output.
+ */
+
+/** number of synthetic corpora */
+#define CORPUS_COUNT 5
+static const char* corpus_names[CORPUS_COUNT] = {"uniform", "zipf", "markov", "runs", "records"};
+
+/** Benchmarked configuration */
+typedef struct
+{
+  const char* engine;
+  int precision;
+  /** cumulative table update range (adaptive engine) or window size
+   *  (decay engine, decay rate 2^-2) */
+  int update_range;
+  /** clear of the occurence counts at each update (adaptive engine) */
+  int range_clear;
+} config_t;
+
+static const config_t configs[] = {
+  {"static", 12, 0, 0}, {"static", 16, 0, 0}, {"static", 20, 0, 0},
+  {"adaptive", 16, 64, 1}, {"adaptive", 16, 1024, 1}, {"adaptive", 16, 16384, 1},
+  {"adaptive", 16, 1024, 0}, {"adaptive", 12, 1024, 1}, {"adaptive", 20, 1024, 1},
+  {"binary", 16, 0, 0}, {"rans", 16, 0, 0}, {"fenwick", 16, 0, 0}, {"wide", 32, 0, 0},
+  {"order1", 16, 0, 0}, {"order2", 16, 0, 0}, {"decay", 16, 64, 0}, {"decay", 16, 1024, 0},
+  {"lz", 16, 0, 0},
+};
+#define CONFIG_COUNT ((int) (sizeof(configs) / sizeof(configs[0])))
+
+/** xorshift64* generator: corpora only depend on the seed */
+static uint64_t prng_state;
+
+static uint64_t prng(void)
+{
+  prng_state ^= prng_state >> 12;
+  prng_state ^= prng_state << 25;
+  prng_state ^= prng_state >> 27;
+  return prng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/** Fill @p out with @p size bytes of corpus @p corpus */
+static void generate_corpus(unsigned char* out, size_t size, int corpus)
+{
+  size_t i;
+  int s;
+
+  prng_state = 0x9E3779B97F4A7C15ULL + corpus;
+
+  switch (corpus) {
+  case 0: // uniform bytes
+    for (i = 0; i < size; ++i) out[i] = (unsigned char) (prng() >> 56);
+    break;
+  case 1: { // Zipf-distributed bytes (exponent 1), ranks shuffled over the alphabet
+    double cumul[256], sum = 0;
+    unsigned char symbol[256];
+    for (s = 0; s < 256; ++s) {
+      sum += 1.0 / (s + 1);
+      cumul[s] = sum;
+      symbol[s] = (unsigned char) s;
+    }
+    for (s = 255; s > 0; --s) {
+      int j = prng() % (s + 1);
+      unsigned char t = symbol[s]; symbol[s] = symbol[j]; symbol[j] = t;
+    }
+    for (i = 0; i < size; ++i) {
+      double u = (prng() >> 11) * (1.0 / 9007199254740992.0) * sum;
+      int lo = 0, hi = 255;
+      while (lo < hi) {
+        int m = (lo + hi) / 2;
+        if (cumul[m] < u) lo = m + 1;
+        else hi = m;
+      }
+      out[i] = symbol[lo];
+    }
+    break;
+  }
+  case 2: { // order-1 Markov text-like: each letter has 4 likely successors
+    const char alphabet[] = "etaoinshrdlcumwfgypbvkjxqz ,.\n";
+    const int letters = sizeof(alphabet) - 1;
+    int next[32][4];
+    int j, c = 0;
+    for (s = 0; s < letters; ++s) {
+      for (j = 0; j < 4; ++j) next[s][j] = prng() % letters;
+    }
+    for (i = 0; i < size; ++i) {
+      uint64_t r = prng();
+      // 7/8 of the transitions are likely ones, the first one being favored
+      if (r & 7) c = next[c][(r >> 3) & 1 ? 0 : (r >> 4) & 3];
+      else c = (r >> 8) % letters;
+      out[i] = alphabet[c];
+    }
+    break;
+  }
+  case 3: // sparse data: zeros with runs of repeated bytes
+    for (i = 0; i < size;) {
+      uint64_t r = prng();
+      size_t run = 1 + (r & 63);
+      unsigned char value = (r >> 8) % 4 ? 0 : (unsigned char) (r >> 16);
+      while (run-- && i < size) out[i++] = value;
+    }
+    break;
+  default: { // binary records: 16-byte little-endian structures
+    uint32_t id = 0, timestamp = 1500000000;
+    for (i = 0; i < size; ++i) {
+      size_t field = i % 16;
+      if (field == 0) {
+        id++;
+        timestamp += prng() % 16;
+      }
+      uint64_t r = prng();
+      out[i] = field < 4 ? (unsigned char) (id >> (8 * field))
+             : field < 8 ? (unsigned char) (timestamp >> (8 * (field - 4)))
+             : field == 8 ? (unsigned char) (r % 5)
+             : field < 12 ? (unsigned char) ((r >> 8) % 3 ? 0 : r >> 16)
+             : (unsigned char) (r >> 24);
+    }
+    break;
+  }
+  }
+}
+
+/** Time stamp counter (0 if not available on the target) */
+static uint64_t read_cycles(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  uint32_t lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t) hi << 32) | lo;
+#else
+  return 0;
+#endif
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** Coding context shared by the encode and decode runs */
+typedef struct
+{
+  const config_t* config;
+  const unsigned char* in;
+  size_t size;
+  unsigned char* encoded;
+  size_t encoded_size;
+  unsigned char* decoded;
+  ac_state_t state;
+  wide_state_t wide;
+} bench_t;
+
+/** Order of the context modeling engines, 0 for the other engines */
+static int context_order(const config_t* c)
+{
+  if (!strcmp(c->engine, "order1")) return 1;
+  if (!strcmp(c->engine, "order2")) return 2;
+  return 0;
+}
+
+/** Window of the decay engine (log2 of its update range) */
+static int decay_window_bits(const config_t* c)
+{
+  int bits = 0;
+  while ((1 << bits) < c->update_range) bits++;
+  return bits;
+}
+
+static void run_encode(bench_t* b)
+{
+  const config_t* c = b->config;
+
+  if (!strcmp(c->engine, "static")) {
+    init_encoding(&b->state);
+    encode_value(b->encoded, b->in, b->size, &b->state);
+    b->encoded_size = b->state.byte_index;
+  } else if (!strcmp(c->engine, "adaptive")) {
+    init_encoding(&b->state);
+    reset_uniform_probability(&b->state);
+    encode_value_with_update(b->encoded, (unsigned char*) b->in, b->size, &b->state, c->update_range,
+                             c->range_clear);
+    b->encoded_size = b->state.byte_index;
+  } else if (!strcmp(c->engine, "binary")) {
+    b->encoded_size = encode_value_binary(b->encoded, b->in, b->size, &b->state);
+  } else if (!strcmp(c->engine, "rans")) {
+    b->encoded_size = rans_encode_value(b->encoded, b->in, b->size, &b->state);
+  } else if (!strcmp(c->engine, "fenwick")) {
+    fenwick_model_t model;
+    init_encoding(&b->state);
+    init_fenwick_model(&model, 32, 1 << 15);
+    encode_value_fenwick(b->encoded, b->in, b->size, &b->state, &model);
+    b->encoded_size = b->state.byte_index;
+  } else if (!strcmp(c->engine, "lz")) {
+    // 64 KiB window, 16 candidates per match search
+    init_encoding(&b->state);
+    encode_value_lz(b->encoded, b->in, b->size, &b->state, 16, 16);
+    b->encoded_size = b->state.byte_index;
+  } else if (!strcmp(c->engine, "decay")) {
+    init_encoding(&b->state);
+    encode_value_with_decay(b->encoded, b->in, b->size, &b->state, decay_window_bits(c), 2);
+    b->encoded_size = b->state.byte_index;
+  } else if (context_order(c)) {
+    // context allocation is part of the coding time
+    context_model_t model;
+    init_encoding(&b->state);
+    init_context_model(&model, context_order(c), context_order(c) == 1 ? 8 : 16, 32, 1 << 15);
+    encode_value_context(b->encoded, b->in, b->size, &b->state, &model);
+    free_context_model(&model);
+    b->encoded_size = b->state.byte_index;
+  } else {
+    b->encoded_size = encode_value_wide(b->encoded, b->in, b->size, &b->wide);
+  }
+}
+
+static void run_decode(bench_t* b)
+{
+  const config_t* c = b->config;
+
+  if (!strcmp(c->engine, "static")) {
+    decode_value(b->decoded, b->encoded, &b->state, b->size);
+  } else if (!strcmp(c->engine, "adaptive")) {
+    reset_uniform_probability(&b->state);
+    decode_value_with_update(b->decoded, b->encoded, &b->state, b->size, c->update_range,
+                             c->range_clear);
+  } else if (!strcmp(c->engine, "binary")) {
+    decode_value_binary(b->decoded, b->encoded, &b->state, b->size);
+  } else if (!strcmp(c->engine, "rans")) {
+    rans_decode_value(b->decoded, b->encoded, &b->state, b->size);
+  } else if (!strcmp(c->engine, "fenwick")) {
+    fenwick_model_t model;
+    init_fenwick_model(&model, 32, 1 << 15);
+    decode_value_fenwick(b->decoded, b->encoded, &b->state, &model, b->size);
+  } else if (!strcmp(c->engine, "lz")) {
+    decode_value_lz(b->decoded, b->encoded, &b->state, b->size);
+  } else if (!strcmp(c->engine, "decay")) {
+    decode_value_with_decay(b->decoded, b->encoded, &b->state, b->size, decay_window_bits(c), 2);
+  } else if (context_order(c)) {
+    context_model_t model;
+    init_context_model(&model, context_order(c), context_order(c) == 1 ? 8 : 16, 32, 1 << 15);
+    decode_value_context(b->decoded, b->encoded, &b->state, &model, b->size);
+    free_context_model(&model);
+  } else {
+    decode_value_wide(b->decoded, b->encoded, &b->wide, b->size);
+  }
+}
+
+static int compare_double(const void* a, const void* b)
+{
+  double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+/** Nearest-rank percentile @p p of the sorted array @p values */
+static double percentile(const double* values, int count, double p)
+{
+  int rank = (int) (p * (count - 1) + 0.5);
+  return values[rank];
+}
+
+/** Time @p reps runs of @p run (after @p warmup runs), filling @p rate
+ *  (MB/s, sorted) and @p cycles (cycles/byte, sorted) */
+static void measure(bench_t* b, void (*run)(bench_t*), int warmup, int reps, double* rate, double* cycles)
+{
+  int r;
+
+  for (r = 0; r < warmup; ++r) run(b);
+  for (r = 0; r < reps; ++r) {
+    uint64_t c0 = read_cycles();
+    double t0 = now();
+    run(b);
+    double t1 = now();
+    uint64_t c1 = read_cycles();
+    rate[r]   = t1 > t0 ? b->size / (t1 - t0) / 1e6 : 0.0;
+    cycles[r] = b->size ? (c1 - c0) / (double) b->size : 0.0;
+  }
+  qsort(rate, reps, sizeof(double), compare_double);
+  qsort(cycles, reps, sizeof(double), compare_double);
+}
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "usage: %s [-s min_size] [-m max_size] [-r repetitions] [-w warmup] [-e engine]\n"
+                  "  sizes go from min_size to max_size by factors of 16 (default 1 KiB to 4 MiB,\n"
+                  "  at most 1 GiB), engine restricts the run to one engine\n", name);
+  exit(1);
+}
+
+int main(int argc, char** argv)
+{
+  size_t min_size = 1 << 10, max_size = 1 << 22, size;
+  int reps = 5, warmup = 1;
+  const char* engine = NULL;
+  int option, corpus, c;
+
+  while ((option = getopt(argc, argv, "s:m:r:w:e:")) != -1) {
+    switch (option) {
+    case 's': min_size = strtoull(optarg, NULL, 0); break;
+    case 'm': max_size = strtoull(optarg, NULL, 0); break;
+    case 'r': reps = atoi(optarg); break;
+    case 'w': warmup = atoi(optarg); break;
+    case 'e': engine = optarg; break;
+    default: usage(argv[0]);
+    }
+  }
+  if (min_size == 0 || max_size > ((size_t) 1 << 30) || reps < 1 || warmup < 0) usage(argv[0]);
+
+  double* rate   = malloc(sizeof(double) * reps);
+  double* cycles = malloc(sizeof(double) * reps);
+  assert(rate && cycles && "memory allocation failed");
+
+  printf("corpus,size,engine,precision,update_range,range_clear,encoded_size,ratio,"
+         "encode_mbps_median,encode_mbps_p10,encode_mbps_p90,encode_cycles_per_byte,"
+         "decode_mbps_median,decode_mbps_p10,decode_mbps_p90,decode_cycles_per_byte,repetitions\n");
+
+  for (size = min_size; size <= max_size; size *= 16) {
+    unsigned char* in      = malloc(size);
+    unsigned char* encoded = malloc(wide_bound(size, WIDE_MAX_PRECISION) + rans_bound(size, 20) + 64);
+    unsigned char* decoded = malloc(size);
+    assert(in && encoded && decoded && "memory allocation failed");
+
+    for (corpus = 0; corpus < CORPUS_COUNT; ++corpus) {
+      generate_corpus(in, size, corpus);
+
+      for (c = 0; c < CONFIG_COUNT; ++c) {
+        bench_t b;
+        if (engine && strcmp(engine, configs[c].engine)) continue;
+
+        b.config  = configs + c;
+        b.in      = in;
+        b.size    = size;
+        b.encoded = encoded;
+        b.decoded = decoded;
+
+        // model construction is not timed
+        init_state(&b.state, configs[c].precision <= 24 ? configs[c].precision : 16);
+        build_probability_table(&b.state, in, size);
+        enable_decode_lookup(&b.state);
+        init_wide_state(&b.wide, configs[c].precision >= WIDE_MIN_PRECISION ? configs[c].precision : WIDE_MAX_PRECISION);
+        wide_build_probability_table(&b.wide, in, size);
+
+        measure(&b, run_encode, warmup, reps, rate, cycles);
+        printf("%s,%zu,%s,%d,%d,%d,%zu,%.4f,%.2f,%.2f,%.2f,%.2f,", corpus_names[corpus], size,
+               configs[c].engine, configs[c].precision, configs[c].update_range, configs[c].range_clear,
+               b.encoded_size,
+               b.encoded_size / (double) size, percentile(rate, reps, 0.5), percentile(rate, reps, 0.1),
+               percentile(rate, reps, 0.9), percentile(cycles, reps, 0.5));
+
+        memset(encoded + b.encoded_size, 0, 8);
+        measure(&b, run_decode, warmup, reps, rate, cycles);
+        if (memcmp(in, decoded, size)) {
+          fprintf(stderr, "error: %s decoding mismatch on %s (%zu bytes)\n", configs[c].engine,
+                  corpus_names[corpus], size);
+          return 1;
+        }
+        printf("%.2f,%.2f,%.2f,%.2f,%d\n", percentile(rate, reps, 0.5), percentile(rate, reps, 0.1),
+               percentile(rate, reps, 0.9), percentile(cycles, reps, 0.5), reps);
+        fflush(stdout);
+
+        ac_free_state(&b.state);
+      }
+    }
+
+    free(in);
+    free(encoded);
+    free(decoded);
+  }
+
+  free(rate);
+  free(cycles);
+
+  return 0;
+}
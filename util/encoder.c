@@ -1,67 +1,862 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
 #include <assert.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "arith_coding.h"
+#include "binary_coding.h"
 
+/** File format: a header followed by independently coded blocks and a
+ *  block index.
+ *
+ *  header (big-endian):
+ *    magic "ACZ" + format version (4 bytes)
+ *    engine, precision, range_clear, reserved (1 byte each)
+ *    update_range (4 bytes), block size (4 bytes)
+ *    original size (8 bytes, all ones if unknown when compressing)
+ *    checksum of the original data (4 bytes, 0 if it is only stored at the
+ *    end of stream, as written by the current encoder)
+ *  block: original size (4 bytes), coded size (4 bytes), coded data, which
+ *  starts with a block mode tag (version 3): AC_BLOCK_CODED followed by the
+ *  engine output or AC_BLOCK_RAW followed by the original bytes
+ *  end of stream: a block of original size 0 followed by the original size
+ *  (8 bytes) and checksum (4 bytes)
+ *  block index (version 2): the position of each block in the file (8 bytes
+ *  each), followed by the number of blocks (8 bytes) and "ACZI"; all the
+ *  blocks but the last one holding block size bytes, the block of any
+ *  original position is found without reading the previous ones
+ */
+#define FORMAT_VERSION 3
+#define HEADER_SIZE 28
+#define UNKNOWN_SIZE UINT64_MAX
+#define INDEX_MAGIC "ACZI"
 
-#include <sys/stat.h>
+/** coding engines */
+#define ENGINE_AC     0
+#define ENGINE_STATIC 1
+#define ENGINE_BINARY 2
+
+static const char* engine_names[] = {"ac", "static", "binary"};
+
+/** maximal number of coding workers */
+#define MAX_WORKERS 64
+
+/** Coding parameters stored in the header */
+typedef struct
+{
+  int version;
+  int engine;
+  int precision;
+  int update_range;
+  int range_clear;
+  size_t block_size;
+} params_t;
+
+/** Input file, memory-mapped when it is a regular file */
+typedef struct
+{
+  FILE* stream;
+  const unsigned char* map;
+  size_t size;
+  size_t position;
+  /** size of the mapping prefix whose pages have been released */
+  size_t released;
+  /** number of bytes before the current position kept mapped (blocks
+   *  still being coded or written) */
+  size_t keep;
+} input_t;
+
+/** Block of the coding pipeline */
+typedef struct
+{
+  /** input buffer: original block read from a stream (compression) or
+   *  coded block (decompression) */
+  unsigned char* buffer;
+  /** original block, in buffer or in the input mapping (compression) */
+  const unsigned char* data;
+  /** original and coded sizes */
+  size_t size;
+  size_t coded_size;
+  /** output buffer: block header and coded data (compression) or decoded
+   *  block (decompression) */
+  unsigned char* out;
+  /** set once the block has been coded */
+  int coded;
+} slot_t;
+
+/** Three-stage coding pipeline: a reader thread fills a ring of slots,
+ *  coding workers process them and the writer (calling thread) emits them
+ *  in order. Block n uses slots[n % slot_count], the counters only grow:
+ *  write_count <= claim_count <= read_count <= write_count + slot_count.
+ *  The counters and coded flags are protected by lock, each change being
+ *  signaled on changed. */
+typedef struct
+{
+  const params_t* params;
+  input_t* input;
+  FILE* output;
+  int decompress;
+
+  slot_t* slots;
+  size_t slot_count;
+  /** number of blocks read, claimed by a worker and written */
+  uint64_t read_count;
+  uint64_t claim_count;
+  uint64_t write_count;
+  /** set by the reader at the end of the input */
+  int end;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+
+  /** writer state: total size and checksum of the original data, block
+   *  index (compression) */
+  uint64_t total;
+  uint32_t checksum;
+  unsigned char* index;
+  size_t index_capacity;
+  size_t block_count;
+  uint64_t position;
+  /** end of stream trailer read by the reader (decompression) */
+  unsigned char trailer[12];
+} pipeline_t;
+
+/** Coding worker of a pipeline, with its own coder state */
+typedef struct
+{
+  pipeline_t* pipeline;
+  ac_state_t state;
+  pthread_t thread;
+} worker_t;
+
+static void fail(const char* message)
+{
+  fprintf(stderr, "error: %s\n", message);
+  exit(1);
+}
+
+/** Wall-clock time in seconds */
+static double wall_time(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void store_be(unsigned char* out, uint64_t value, int bytes)
+{
+  int i;
+  for (i = 0; i < bytes; ++i) out[i] = (unsigned char) (value >> (8 * (bytes - 1 - i)));
+}
+
+static uint64_t load_be(const unsigned char* in, int bytes)
+{
+  uint64_t value = 0;
+  int i;
+  for (i = 0; i < bytes; ++i) value = (value << 8) | in[i];
+  return value;
+}
+
+/** Adler-32 checksum of @p size bytes of @p in, continuing from @p adler */
+static uint32_t adler32(uint32_t adler, const unsigned char* in, size_t size)
+{
+  uint32_t a = adler & 0xffff, b = adler >> 16;
+
+  while (size > 0) {
+    // largest run without 32-bit overflow of b
+    size_t run = size < 5552 ? size : 5552;
+    size -= run;
+    while (run--) {
+      a += *in++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+
+  return (b << 16) | a;
+}
+
+/** Open @p filename ("-" or NULL for stdin), mapping it if possible */
+static void open_input(input_t* input, const char* filename)
+{
+  struct stat st;
+  int fd = filename && strcmp(filename, "-") ? open(filename, O_RDONLY) : STDIN_FILENO;
+
+  if (fd < 0) fail("can not open input file");
+
+  input->stream   = NULL;
+  input->map      = NULL;
+  input->size     = 0;
+  input->position = 0;
+  input->released = 0;
+  input->keep     = 0;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    input->size = st.st_size;
+    if (input->size > 0) {
+      void* map = mmap(NULL, input->size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) fail("can not map input file");
+      madvise(map, input->size, MADV_SEQUENTIAL);
+      input->map = map;
+    }
+    if (fd != STDIN_FILENO) close(fd);
+    return;
+  }
+
+  input->stream = fdopen(fd, "rb");
+  if (!input->stream) fail("can not open input stream");
+}
+
+static void close_input(input_t* input)
+{
+  if (input->map) munmap((void*) input->map, input->size);
+  if (input->stream && input->stream != stdin) fclose(input->stream);
+}
+
+/** Next @p size bytes of @p input: a pointer into the mapping or into
+ *  @p buffer (filled from the input stream)
+ *  @return number of available bytes (lower than @p size at the end)
+ */
+static size_t read_input(input_t* input, unsigned char* buffer, size_t size, const unsigned char** data)
+{
+  if (input->stream) {
+    *data = buffer;
+    return fread(buffer, 1, size, input->stream);
+  }
+
+  // pages consumed by the previous reads (but the last keep bytes) are
+  // released, so that the resident part of the mapping stays bounded
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t consumed = (input->position > input->keep ? input->position - input->keep : 0) / page * page;
+  if (consumed > input->released) {
+    madvise((void*) (input->map + input->released), consumed - input->released, MADV_DONTNEED);
+    input->released = consumed;
+  }
+
+  if (size > input->size - input->position) size = input->size - input->position;
+  *data = input->map + input->position;
+  input->position += size;
+  return size;
+}
+
+/** Read exactly @p size bytes of @p input to @p buffer */
+static void read_exact(input_t* input, unsigned char* buffer, size_t size)
+{
+  const unsigned char* data;
+  if (read_input(input, buffer, size, &data) != size) fail("truncated input");
+  if (data != buffer) memcpy(buffer, data, size);
+}
+
+static void write_output(FILE* output, const unsigned char* data, size_t size)
+{
+  if (output && fwrite(data, 1, size, output) != size) fail("can not write output");
+}
+
+/** Upper bound on the coded size of a block of @p size bytes (and its
+ *  block mode tag) */
+static size_t block_bound(const params_t* params, size_t size)
+{
+  size_t table_bound = AC_TABLE_HEADER_BOUND + encode_bound(size, params->precision);
+  size_t bit_bound   = binary_bound(size);
+  return 1 + (table_bound > bit_bound ? table_bound : bit_bound);
+}
+
+/** Code the block @p in of @p size bytes to @p out with a reset @p state
+ *  and the table based engine of @p params
+ *  @return coded size */
+static size_t encode_engine(const params_t* params, ac_state_t* state, unsigned char* out,
+                            const unsigned char* in, size_t size)
+{
+  if (params->engine == ENGINE_STATIC) return encode_value_with_table(out, in, size, state);
+  return encode_value_binary(out, in, size, state);
+}
+
+/** Code the block @p in of @p size bytes to @p out, preceded by its block
+ *  mode tag: blocks estimated incompressible (or coded to more than their
+ *  size) are stored raw
+ *  @return coded size */
+static size_t encode_block(const params_t* params, ac_state_t* state, unsigned char* out,
+                           const unsigned char* in, size_t size)
+{
+  if (params->engine == ENGINE_AC) {
+    return encode_value_auto(out, in, size, state, params->update_range, params->range_clear);
+  }
+
+  if (estimate_compressible(in, size)) {
+    size_t coded_size = encode_engine(params, state, out + 1, in, size);
+    if (coded_size < size) {
+      out[0] = AC_BLOCK_CODED;
+      return 1 + coded_size;
+    }
+  }
+
+  return store_value_raw(out, in, size);
+}
+
+static void decode_engine(const params_t* params, ac_state_t* state, unsigned char* out,
+                          unsigned char* in, size_t size)
+{
+  switch (params->engine) {
+  case ENGINE_STATIC:
+    decode_value_with_table(out, in, state, size);
+    break;
+  case ENGINE_BINARY:
+    decode_value_binary(out, in, state, size);
+    break;
+  default:
+    reset_uniform_probability(state);
+    decode_value_with_update(out, in, state, size, params->update_range, params->range_clear);
+    break;
+  }
+}
+
+/** Decode the block @p in (@p coded_size bytes) of @p size original bytes */
+static void decode_block(const params_t* params, ac_state_t* state, unsigned char* out,
+                         unsigned char* in, size_t size, size_t coded_size)
+{
+  // blocks of format versions 1 and 2 have no block mode tag
+  if (params->version < 3) {
+    decode_engine(params, state, out, in, size);
+    return;
+  }
 
-off_t fsize(const char *filename) {
-    struct stat st; 
+  if (coded_size < 1 || (in[0] != AC_BLOCK_CODED && in[0] != AC_BLOCK_RAW)) fail("corrupted block");
+  if (in[0] == AC_BLOCK_CODED) {
+    decode_engine(params, state, out, in + 1, size);
+  } else {
+    if (coded_size != 1 + size) fail("corrupted block");
+    memcpy(out, in + 1, size);
+  }
+}
+
+/** Load and check the header of a compressed file */
+static void load_header(const unsigned char* header, params_t* params)
+{
+  if (memcmp(header, "ACZ", 3)) fail("not a compressed file");
+  if (header[3] < 1 || header[3] > FORMAT_VERSION) fail("unsupported format version");
+
+  params->version      = header[3];
+  params->engine       = header[4];
+  params->precision    = header[5];
+  params->range_clear  = header[6];
+  params->update_range = load_be(header + 8, 4);
+  params->block_size   = load_be(header + 12, 4);
+
+  if (params->engine > ENGINE_BINARY || params->precision < 12 || params->precision > 24 ||
+      params->block_size == 0) {
+    fail("invalid header");
+  }
+}
+
+/** Upper bound on the size of a coded block and its padding (the
+ *  decoders read ahead) */
+static size_t encoded_capacity(const params_t* params)
+{
+  return block_bound(params, params->block_size) + AC_DECODE_PADDING;
+}
+
+static void init_pipeline(pipeline_t* pipeline, const params_t* params, input_t* input, FILE* output,
+                          int decompress, int workers)
+{
+  size_t i;
 
-    if (stat(filename, &st) == 0)
-        return st.st_size;
+  pipeline->params     = params;
+  pipeline->input      = input;
+  pipeline->output     = output;
+  pipeline->decompress = decompress;
 
-    return -1; 
+  // each worker has a block in progress while the reader and the writer
+  // work on the others
+  pipeline->slot_count = 2 * workers + 2;
+  pipeline->slots = calloc(pipeline->slot_count, sizeof(slot_t));
+  assert(pipeline->slots && "memory allocation failed");
+  for (i = 0; i < pipeline->slot_count; ++i) {
+    slot_t* slot = pipeline->slots + i;
+    if (decompress) {
+      slot->buffer = malloc(encoded_capacity(params));
+      slot->out    = malloc(params->block_size);
+    } else {
+      slot->buffer = input->stream ? malloc(params->block_size) : NULL;
+      slot->out    = malloc(8 + block_bound(params, params->block_size));
+    }
+    assert((slot->buffer || (!decompress && !input->stream)) && slot->out && "memory allocation failed");
+  }
+
+  // mapped blocks are used in place until they are written
+  if (!decompress) input->keep = pipeline->slot_count * params->block_size;
+
+  pipeline->read_count  = 0;
+  pipeline->claim_count = 0;
+  pipeline->write_count = 0;
+  pipeline->end         = 0;
+  pthread_mutex_init(&pipeline->lock, NULL);
+  pthread_cond_init(&pipeline->changed, NULL);
+
+  pipeline->total          = 0;
+  pipeline->checksum       = adler32(1, NULL, 0);
+  pipeline->index_capacity = 64;
+  pipeline->block_count    = 0;
+  pipeline->position       = HEADER_SIZE;
+  pipeline->index = decompress ? NULL : malloc(8 * pipeline->index_capacity);
+  assert((decompress || pipeline->index) && "memory allocation failed");
+}
+
+static void free_pipeline(pipeline_t* pipeline)
+{
+  size_t i;
+
+  for (i = 0; i < pipeline->slot_count; ++i) {
+    free(pipeline->slots[i].buffer);
+    free(pipeline->slots[i].out);
+  }
+  free(pipeline->slots);
+  free(pipeline->index);
+  pthread_mutex_destroy(&pipeline->lock);
+  pthread_cond_destroy(&pipeline->changed);
+  pipeline->input->keep = 0;
 }
 
-int main(int argc, char** argv) { 
-  if (argc <= 2) {
-    printf("usage: %s <filename> <update_range)\n", argv[0]);
-    return 1;
-  };
+/** Read the next block of the pipeline input to @p slot
+ *  @return 0 at the end of the input */
+static int read_block(pipeline_t* pipeline, slot_t* slot)
+{
+  const params_t* params = pipeline->params;
+  input_t* input = pipeline->input;
+
+  if (!pipeline->decompress) {
+    slot->size = read_input(input, slot->buffer, params->block_size, &slot->data);
+    return slot->size > 0;
+  }
+
+  unsigned char block_header[8];
+  read_exact(input, block_header, 8);
+  slot->size       = load_be(block_header, 4);
+  slot->coded_size = load_be(block_header + 4, 4);
+  if (slot->size == 0) {
+    read_exact(input, pipeline->trailer, 12);
+    return 0;
+  }
+  if (slot->size > params->block_size || slot->coded_size > encoded_capacity(params) - 8) fail("corrupted block");
+
+  read_exact(input, slot->buffer, slot->coded_size);
+  memset(slot->buffer + slot->coded_size, 0, 8);
+  return 1;
+}
+
+static void code_block(pipeline_t* pipeline, ac_state_t* state, slot_t* slot)
+{
+  if (pipeline->decompress) {
+    decode_block(pipeline->params, state, slot->out, slot->buffer, slot->size, slot->coded_size);
+    return;
+  }
+
+  slot->coded_size = encode_block(pipeline->params, state, slot->out + 8, slot->data, slot->size);
+  store_be(slot->out, slot->size, 4);
+  store_be(slot->out + 4, slot->coded_size, 4);
+}
+
+static void write_block(pipeline_t* pipeline, slot_t* slot)
+{
+  if (pipeline->decompress) {
+    write_output(pipeline->output, slot->out, slot->size);
+    pipeline->checksum = adler32(pipeline->checksum, slot->out, slot->size);
+    pipeline->total   += slot->size;
+    return;
+  }
+
+  write_output(pipeline->output, slot->out, 8 + slot->coded_size);
+
+  if (pipeline->block_count == pipeline->index_capacity) {
+    pipeline->index_capacity *= 2;
+    pipeline->index = realloc(pipeline->index, 8 * pipeline->index_capacity);
+    assert(pipeline->index && "memory allocation failed");
+  }
+  store_be(pipeline->index + 8 * pipeline->block_count++, pipeline->position, 8);
+  pipeline->position += 8 + slot->coded_size;
+
+  pipeline->checksum = adler32(pipeline->checksum, slot->data, slot->size);
+  pipeline->total   += slot->size;
+}
+
+static void* reader_thread(void* arg)
+{
+  pipeline_t* pipeline = arg;
+
+  while (1) {
+    // waiting for a slot released by the writer
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->read_count - pipeline->write_count == pipeline->slot_count) {
+      pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+    }
+    slot_t* slot = pipeline->slots + pipeline->read_count % pipeline->slot_count;
+    pthread_mutex_unlock(&pipeline->lock);
+
+    int read = read_block(pipeline, slot);
+
+    pthread_mutex_lock(&pipeline->lock);
+    if (read) {
+      slot->coded = 0;
+      pipeline->read_count++;
+    } else {
+      pipeline->end = 1;
+    }
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+
+    if (!read) return NULL;
+  }
+}
+
+static void* coding_worker(void* arg)
+{
+  worker_t* worker = arg;
+  pipeline_t* pipeline = worker->pipeline;
+
+  while (1) {
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->claim_count == pipeline->read_count && !pipeline->end) {
+      pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+    }
+    if (pipeline->claim_count == pipeline->read_count) {
+      pthread_mutex_unlock(&pipeline->lock);
+      return NULL;
+    }
+    slot_t* slot = pipeline->slots + pipeline->claim_count++ % pipeline->slot_count;
+    pthread_mutex_unlock(&pipeline->lock);
+
+    code_block(pipeline, &worker->state, slot);
+
+    pthread_mutex_lock(&pipeline->lock);
+    slot->coded = 1;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+  }
+}
+
+/** Run @p pipeline on the calling thread only, each block being read,
+ *  coded with @p state and written in turn */
+static void run_sequential(pipeline_t* pipeline, ac_state_t* state)
+{
+  slot_t* slot = pipeline->slots;
+
+  while (read_block(pipeline, slot)) {
+    code_block(pipeline, state, slot);
+    write_block(pipeline, slot);
+  }
+}
+
+/** Run @p pipeline with @p workers coding threads until the end of its
+ *  input, the blocks being written by the calling thread (which runs the
+ *  whole pipeline if the reader or all the workers can not be started) */
+static void run_pipeline(pipeline_t* pipeline, int workers)
+{
+  worker_t* worker = malloc(sizeof(worker_t) * workers);
+  pthread_t reader;
+  int i, started = 0;
+
+  assert(worker && "memory allocation failed");
+
+  for (i = 0; i < workers; ++i) {
+    worker[i].pipeline = pipeline;
+    init_state(&worker[i].state, pipeline->params->precision);
+  }
+  while (started < workers && !pthread_create(&worker[started].thread, NULL, coding_worker, worker + started)) {
+    started++;
+  }
+
+  if (!started || pthread_create(&reader, NULL, reader_thread, pipeline)) {
+    // no block will be read: the started workers return at once
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->end = 1;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    for (i = 0; i < started; ++i) pthread_join(worker[i].thread, NULL);
+
+    run_sequential(pipeline, &worker[0].state);
+  } else {
+    while (1) {
+      // waiting for the next block to be coded
+      pthread_mutex_lock(&pipeline->lock);
+      while (pipeline->write_count == pipeline->read_count ? !pipeline->end
+             : !pipeline->slots[pipeline->write_count % pipeline->slot_count].coded) {
+        pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+      }
+      if (pipeline->write_count == pipeline->read_count) {
+        pthread_mutex_unlock(&pipeline->lock);
+        break;
+      }
+      slot_t* slot = pipeline->slots + pipeline->write_count % pipeline->slot_count;
+      pthread_mutex_unlock(&pipeline->lock);
+
+      write_block(pipeline, slot);
+
+      pthread_mutex_lock(&pipeline->lock);
+      pipeline->write_count++;
+      pthread_cond_broadcast(&pipeline->changed);
+      pthread_mutex_unlock(&pipeline->lock);
+    }
+
+    pthread_join(reader, NULL);
+    for (i = 0; i < started; ++i) pthread_join(worker[i].thread, NULL);
+  }
+
+  for (i = 0; i < workers; ++i) ac_free_state(&worker[i].state);
+  free(worker);
+}
+
+static void compress(const params_t* params, input_t* input, FILE* output, int workers)
+{
+  unsigned char header[HEADER_SIZE];
+  uint64_t original_size = input->stream ? UNKNOWN_SIZE : input->size;
+
+  memcpy(header, "ACZ", 3);
+  header[3] = FORMAT_VERSION;
+  header[4] = params->engine;
+  header[5] = params->precision;
+  header[6] = params->range_clear;
+  header[7] = 0;
+  store_be(header + 8, params->update_range, 4);
+  store_be(header + 12, params->block_size, 4);
+  store_be(header + 16, original_size, 8);
+  // the input is only read once, by the pipeline: its checksum is stored
+  // at the end of stream
+  store_be(header + 24, 0, 4);
+  write_output(output, header, HEADER_SIZE);
+
+  pipeline_t pipeline;
+  init_pipeline(&pipeline, params, input, output, 0, workers);
+  run_pipeline(&pipeline, workers);
+
+  // end of stream
+  unsigned char trailer[20];
+  store_be(trailer, 0, 8);
+  store_be(trailer + 8, pipeline.total, 8);
+  store_be(trailer + 16, pipeline.checksum, 4);
+  write_output(output, trailer, 20);
+
+  unsigned char index_trailer[12];
+  store_be(index_trailer, pipeline.block_count, 8);
+  memcpy(index_trailer + 8, INDEX_MAGIC, 4);
+  write_output(output, pipeline.index, 8 * pipeline.block_count);
+  write_output(output, index_trailer, 12);
+
+  free_pipeline(&pipeline);
+}
+
+/** @return total decoded size */
+static uint64_t decompress(input_t* input, FILE* output, int workers)
+{
+  unsigned char header[HEADER_SIZE];
+  params_t params;
+
+  read_exact(input, header, HEADER_SIZE);
+  load_header(header, &params);
+  uint64_t original_size = load_be(header + 16, 8);
+  uint32_t expected_checksum = load_be(header + 24, 4);
+
+  pipeline_t pipeline;
+  init_pipeline(&pipeline, &params, input, output, 1, workers);
+  run_pipeline(&pipeline, workers);
+
+  uint64_t total = pipeline.total;
+  uint32_t checksum = pipeline.checksum;
+  if (load_be(pipeline.trailer, 8) != total || (original_size != UNKNOWN_SIZE && original_size != total)) {
+    fail("size mismatch");
+  }
+  if (load_be(pipeline.trailer + 8, 4) != checksum || (expected_checksum && expected_checksum != checksum)) {
+    fail("checksum mismatch");
+  }
+
+  free_pipeline(&pipeline);
+
+  return total;
+}
+
+/** Decode the original bytes [@p offset, @p offset + @p length) of a
+ *  mapped compressed file, only the blocks overlapping the range being
+ *  decoded (checksums are not verified) */
+static void extract(input_t* input, FILE* output, uint64_t offset, uint64_t length)
+{
+  const unsigned char* map = input->map;
+  params_t params;
+
+  if (input->stream) fail("range extraction requires a compressed file (not a stream)");
+  if (input->size < HEADER_SIZE + 20 + 12) fail("truncated input");
+  load_header(map, &params);
+  if (map[3] < 2 || memcmp(map + input->size - 4, INDEX_MAGIC, 4)) fail("no block index (format version 1)");
+  madvise((void*) map, input->size, MADV_RANDOM);
+
+  uint64_t block_count = load_be(map + input->size - 12, 8);
+  if (block_count > (input->size - HEADER_SIZE - 20 - 12) / 8) fail("corrupted block index");
+  const unsigned char* index = map + input->size - 12 - 8 * block_count;
+  uint64_t total = load_be(index - 12, 8);
+  if (offset > total || length > total - offset) fail("range exceeds original size");
+  if (!length) return;
+
+  unsigned char* decoded = malloc(params.block_size);
+  assert(decoded && "memory allocation failed");
+
+  ac_state_t state;
+  init_state(&state, params.precision);
+
+  uint64_t block;
+  for (block = offset / params.block_size; block <= (offset + length - 1) / params.block_size; ++block) {
+    if (block >= block_count) fail("corrupted block index");
+    uint64_t position = load_be(index + 8 * block, 8);
+    if (position < HEADER_SIZE || position > (uint64_t) (index - map) - 8 - 20) fail("corrupted block index");
+
+    // the coded block is followed by (at least) the end of stream trailer,
+    // it is decoded in place
+    size_t size         = load_be(map + position, 4);
+    size_t encoded_size = load_be(map + position + 4, 4);
+    if (size == 0 || size > params.block_size || position + 8 + encoded_size + 20 > (uint64_t) (index - map)) {
+      fail("corrupted block");
+    }
+    decode_block(&params, &state, decoded, (unsigned char*) map + position + 8, size, encoded_size);
+
+    uint64_t start = block * params.block_size;
+    uint64_t begin = offset > start ? offset - start : 0;
+    uint64_t end   = offset + length - start < size ? offset + length - start : size;
+    write_output(output, decoded + begin, end - begin);
+  }
+
+  ac_free_state(&state);
+  free(decoded);
+}
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "usage: %s -c [-e engine] [-p precision] [-u update_range] [-r] [-b block_size] [-j workers] [input [output]]\n"
+                  "       %s -d [-j workers] [input [output]]\n"
+                  "       %s -x offset:length [input [output]] (original range extraction)\n"
+                  "       %s -t [options] input (compression round-trip check)\n"
+                  "  engine: ac (adaptive multi-symbol coder, default), static (self-describing static table)\n"
+                  "          or binary (adaptive bit-tree coder)\n"
+                  "  workers: number of coding threads (default 1), reading and writing\n"
+                  "           running in their own threads\n"
+                  "  input/output default to stdin/stdout (or -)\n", name, name, name, name);
+  exit(1);
+}
+
+int main(int argc, char** argv)
+{
+  params_t params = {FORMAT_VERSION, ENGINE_AC, 16, 1024, 0, 1 << 20};
+  char mode = 0;
+  int option, workers = 1;
+  uint64_t range_offset = 0, range_length = 0;
+
+  // legacy invocation: <filename> <update_range> [engine]
+  const char* legacy_argv[] = {argv[0], "-t", "-u", argc > 2 ? argv[2] : "", "-e", argc > 3 ? argv[3] : "ac",
+                               argv[1], NULL};
+  if (argc >= 3 && argv[1][0] != '-') {
+    argc = 7;
+    argv = (char**) legacy_argv;
+  }
+
+  while ((option = getopt(argc, argv, "cdtx:e:p:u:rb:j:")) != -1) {
+    char* end;
+    switch (option) {
+    case 'c': case 'd': case 't':
+      mode = option;
+      break;
+    case 'x':
+      mode = option;
+      range_offset = strtoull(optarg, &end, 0);
+      if (*end != ':') usage(argv[0]);
+      range_length = strtoull(end + 1, &end, 0);
+      if (*end) usage(argv[0]);
+      break;
+    case 'e':
+      for (params.engine = 0; params.engine <= ENGINE_BINARY; ++params.engine) {
+        if (!strcmp(optarg, engine_names[params.engine])) break;
+      }
+      if (params.engine > ENGINE_BINARY) fail("unknown engine");
+      break;
+    case 'p':
+      params.precision = atoi(optarg);
+      break;
+    case 'u':
+      params.update_range = atoi(optarg);
+      break;
+    case 'r':
+      params.range_clear = 1;
+      break;
+    case 'b':
+      params.block_size = strtoul(optarg, NULL, 0);
+      break;
+    case 'j':
+      workers = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
 
-  const char* filename = argv[1];
-  const int update_range = atoi(argv[2]);
+  if (!mode || argc - optind > 2) usage(argv[0]);
+  if (params.precision < 12 || params.precision > 24) fail("precision must be between 12 and 24");
+  if (params.update_range <= 0) fail("update_range must be positive");
+  if (params.block_size == 0 || params.block_size > (1u << 30)) fail("block size must be between 1 and 2^30");
+  if (workers < 1 || workers > MAX_WORKERS) fail("number of workers must be between 1 and 64");
 
-  FILE*  input_stream = fopen(filename, "r");
+  const char* input_name  = optind < argc ? argv[optind] : NULL;
+  const char* output_name = optind + 1 < argc ? argv[optind + 1] : NULL;
+  input_t input;
 
-  size_t input_size   = fsize(filename);
-  size_t read_buffer_size = input_size;
+  open_input(&input, input_name);
 
-  char* read_buffer    = malloc(input_size * sizeof(char));
-  char* encoded_buffer = malloc((input_size + 100) * sizeof(char));
-  char* decoded_buffer = malloc((input_size + 100) * sizeof(char));
+  if (mode == 't') {
+    // round-trip through a temporary file, no output kept
+    FILE* temporary = tmpfile();
+    if (!temporary) fail("can not create temporary file");
 
-  size_t read_size = fread(read_buffer, sizeof(char), read_buffer_size, input_stream);
+    double start = wall_time();
+    compress(&params, &input, temporary, workers);
+    double encoded = wall_time();
+    fflush(temporary);
 
-  ac_state_t encoder_state;
+    size_t encoded_size = ftell(temporary);
+    input_t coded;
+    coded.stream = NULL;
+    coded.map = NULL;
+    coded.size = encoded_size;
+    coded.position = 0;
+    coded.released = 0;
+    coded.keep = 0;
+    coded.map = mmap(NULL, encoded_size, PROT_READ, MAP_PRIVATE, fileno(temporary), 0);
+    if (coded.map == MAP_FAILED) fail("can not map temporary file");
 
-  // initializing encoding state
-  init_state(&encoder_state, 16);
-  reset_uniform_probability(&encoder_state);
-  //const char reference[] = "reference string";
-  //build_probability_table(&encoder_state, reference, sizeof(reference));
+    double decoding = wall_time();
+    uint64_t decoded_size = decompress(&coded, NULL, workers);
+    double decoded = wall_time();
 
-  // encoding read buffer
-  //encode_value(encoded_buffer, read_buffer, read_size, &encoder_state); 
-  encode_value_with_update(encoded_buffer, read_buffer, read_size, &encoder_state, update_range, 0 /* range clear */); 
+    printf("success: compression ratio is %.3f \n", encoded_size / (double) (decoded_size ? decoded_size : 1) * 100.0);
+    printf("encoding %.3f s, decoding %.3f s\n", encoded - start, decoded - decoding);
 
-  size_t encoded_size = (encoder_state.out_index + 7) / 8;
+    close_input(&coded);
+    fclose(temporary);
+  } else {
+    FILE* output = output_name && strcmp(output_name, "-") ? fopen(output_name, "wb") : stdout;
+    if (!output) fail("can not open output file");
 
-  // decoding buffer 
-  reset_uniform_probability(&encoder_state);
-  //decode_value(decoded_buffer, encoded_buffer, &encoder_state, read_size);
-  decode_value_with_update(decoded_buffer, encoded_buffer, &encoder_state, read_size, update_range, 0/* range clear */);
+    if (mode == 'c') compress(&params, &input, output, workers);
+    else if (mode == 'x') extract(&input, output, range_offset, range_length);
+    else decompress(&input, output, workers);
 
-  if (memcmp(decoded_buffer, read_buffer, read_size)) {
-    printf("Failure encoded and decoded buffer mismatch\n");
-    return 1;
+    if (fclose(output)) fail("can not write output");
   }
 
-  double compression_ratio = encoded_size / (double) read_size * 100.0;
-  printf("success: compression ratio is %.3f \n", compression_ratio);
+  close_input(&input);
 
   return 0;
 }
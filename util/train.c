@@ -0,0 +1,100 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <unistd.h>
+
+#include "arith_coding.h"
+#include "model_file.h"
+
+/** Model training tool: order-0 tables (and context models) are trained on
+ *  a sample corpus and written to a model file (see model_file.h).
+ */
+
+static void fail(const char* message)
+{
+  fprintf(stderr, "error: %s\n", message);
+  exit(1);
+}
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "usage: %s [-p precision] [-o order] [-c context_bits] [-i increment] [-l limit] sample model\n"
+                  "  order: 0 (order-0 tables only, default), 1 or 2 (context models)\n", name);
+  exit(1);
+}
+
+int main(int argc, char** argv)
+{
+  int precision = 16, order = 0, context_bits = 0;
+  uint32_t increment = 32, limit = 1 << 15;
+  int option;
+
+  while ((option = getopt(argc, argv, "p:o:c:i:l:")) != -1) {
+    switch (option) {
+    case 'p':
+      precision = atoi(optarg);
+      break;
+    case 'o':
+      order = atoi(optarg);
+      break;
+    case 'c':
+      context_bits = atoi(optarg);
+      break;
+    case 'i':
+      increment = strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      limit = strtoul(optarg, NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  if (argc - optind != 2) usage(argv[0]);
+  if (precision < 12 || precision > 24) fail("precision must be between 12 and 24");
+  if (!context_bits) context_bits = order == 2 ? 16 : 8;
+  if (order < 0 || order > 2 || (order == 1 && context_bits != 8) ||
+      (order == 2 && (context_bits < 8 || context_bits > 16))) {
+    fail("unsupported context parameters");
+  }
+  if (order && (limit + increment > 0xffff || limit > (1u << (precision - 1)))) {
+    fail("context model limit too large for the precision");
+  }
+
+  // sample corpus
+  FILE* input = fopen(argv[optind], "rb");
+  if (!input) fail("can not open sample file");
+  size_t capacity = 1 << 20, size = 0, read;
+  unsigned char* sample = malloc(capacity);
+  assert(sample && "memory allocation failed");
+  while ((read = fread(sample + size, 1, capacity - size, input)) > 0) {
+    size += read;
+    if (size == capacity) {
+      capacity *= 2;
+      sample = realloc(sample, capacity);
+      assert(sample && "memory allocation failed");
+    }
+  }
+  fclose(input);
+  if (size > 0x7fffffff) fail("sample too large");
+
+  if (!ac_write_model(argv[optind + 1], sample, size, precision, order, context_bits, increment, limit)) {
+    fail("can not write model file");
+  }
+
+  ac_model_t model;
+  if (!ac_load_model(&model, argv[optind + 1])) fail("can not load the written model");
+  printf("trained on %zu Bytes: %zu Bytes model (order %d, %zu contexts)\n", size, model.map_size,
+         model.order, model.context_count);
+  ac_unload_model(&model);
+
+  free(sample);
+
+  return 0;
+}